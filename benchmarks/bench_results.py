@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""Collects EventCore benchmark results into one JSON file and compares two.
+
+  collect  Merges Google Benchmark JSON (--benchmark_out) and benchmark_load
+           --json output with machine info and the git revision. Every result
+           is flattened to a metric "<suite>/<benchmark>:<field>" that records
+           its value, unit and whether lower or higher is better.
+  compare  Reports each metric of a baseline against a new result and exits
+           with 1 when any got worse by more than its tolerance, or when a
+           baseline metric is missing because its benchmark errored or was
+           not run (unless --allow-missing).
+
+run_benchmarks.sh drives both; they can also be run by hand:
+  bench_results.py compare baseline.json results.json --tolerance 5 \\
+      --metric-tolerance 'load/*:latency_p99_us=20'
+"""
+
+import argparse
+import datetime
+import fnmatch
+import json
+import os
+import platform
+import sys
+
+SCHEMA = 1
+
+# Google Benchmark fields and counters worth gating on: (unit, better)
+GBENCH_FIELDS = {
+    "real_time": (None, "lower"),  # In the run's time_unit
+    "cpu_time": (None, "lower"),
+    "items_per_second": ("items/s", "higher"),
+    "bytes_per_second": ("bytes/s", "higher"),
+    "Allocs": ("allocs/iter", "lower"),
+    "AllocBytes": ("bytes/iter", "lower"),
+}
+
+LOAD_FIELDS = {
+    "requests_per_second": ("req/s", "higher"),
+    "mb_per_second": ("MB/s", "higher"),
+    "errors": ("count", "lower"),
+    "non_2xx": ("count", "lower"),
+}
+LOAD_LATENCIES = ("p50", "p99", "p999")
+
+
+def read_json(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def machine_info():
+    info = {
+        "hostname": platform.node(),
+        "system": platform.system(),
+        "kernel": platform.release(),
+        "machine": platform.machine(),
+        "python": platform.python_version(),
+        "cpus": os.cpu_count(),
+    }
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    info["cpu_model"] = line.split(":", 1)[1].strip()
+                    break
+        with open("/proc/meminfo") as f:
+            for line in f:
+                if line.startswith("MemTotal:"):
+                    info["memory_kb"] = int(line.split()[1])
+                    break
+    except OSError:
+        pass
+    return info
+
+
+def gbench_metrics(suite, data, errors):
+    """Medians when the run used repetitions, otherwise the single runs.
+    Runs that reported an error are appended to `errors` instead."""
+    runs = data.get("benchmarks", [])
+    has_median = any(r.get("aggregate_name") == "median" for r in runs)
+    metrics = {}
+    for run in runs:
+        if run.get("error_occurred"):
+            error = "%s/%s: %s" % (suite, run.get("run_name", run["name"]), run.get("error_message", "error"))
+            if error not in errors:
+                errors.append(error)
+            continue
+        if has_median:
+            if run.get("aggregate_name") != "median":
+                continue
+            name = run.get("run_name", run["name"])
+        else:
+            if run.get("run_type") == "aggregate":
+                continue
+            name = run["name"]
+        for field, (unit, better) in GBENCH_FIELDS.items():
+            if field not in run:
+                continue
+            unit = unit or run.get("time_unit", "ns")
+            metrics["%s/%s:%s" % (suite, name, field)] = {
+                "value": run[field], "unit": unit, "better": better}
+    return metrics
+
+
+def load_metrics(scenario, data):
+    metrics = {}
+    for field, (unit, better) in LOAD_FIELDS.items():
+        metrics["load/%s:%s" % (scenario, field)] = {
+            "value": data[field], "unit": unit, "better": better}
+    # Omission-corrected latency when the run was a closed loop
+    latency = data.get("corrected_latency_us", data["latency_us"])
+    for quantile in LOAD_LATENCIES:
+        metrics["load/%s:latency_%s_us" % (scenario, quantile)] = {
+            "value": latency[quantile], "unit": "us", "better": "lower"}
+    return metrics
+
+
+def named_files(values):
+    pairs = []
+    for value in values or []:
+        name, sep, path = value.partition("=")
+        if not sep:
+            sys.exit("Expected NAME=FILE, got %r" % value)
+        pairs.append((name, path))
+    return pairs
+
+
+def collect(args):
+    result = {
+        "schema": SCHEMA,
+        "created": datetime.datetime.now(datetime.timezone.utc).isoformat(timespec="seconds"),
+        "label": args.label,
+        "git": {"revision": args.git_revision, "dirty": args.git_dirty},
+        "machine": machine_info(),
+        "build": {},
+        "settings": {},
+        "metrics": {},
+        "errors": [],
+    }
+    for suite, path in named_files(args.gbench):
+        data = read_json(path)
+        context = data.get("context", {})
+        result["build"].setdefault("library_build_type", context.get("library_build_type"))
+        result["machine"].setdefault("mhz_per_cpu", context.get("mhz_per_cpu"))
+        result["machine"].setdefault("caches", context.get("caches"))
+        result["metrics"].update(gbench_metrics(suite, data, result["errors"]))
+    for scenario, path in named_files(args.load):
+        data = read_json(path)
+        result["settings"]["load/" + scenario] = data.get("settings", {})
+        result["metrics"].update(load_metrics(scenario, data))
+
+    with open(args.out, "w") as f:
+        json.dump(result, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print("%d metrics written to %s" % (len(result["metrics"]), args.out))
+    for error in result["errors"]:
+        print("Benchmark failed: %s" % error)
+    return 0
+
+
+def tolerance_for(name, args):
+    for pattern, tolerance in args.metric_tolerance:
+        if fnmatch.fnmatchcase(name, pattern):
+            return tolerance
+    return args.tolerance
+
+
+def parse_metric_tolerance(value):
+    pattern, sep, tolerance = value.rpartition("=")
+    if not sep:
+        raise argparse.ArgumentTypeError("expected PATTERN=PERCENT, got %r" % value)
+    return pattern, float(tolerance)
+
+
+def compare(args):
+    baseline = read_json(args.baseline)
+    current = read_json(args.current)
+    for result, path in ((baseline, args.baseline), (current, args.current)):
+        if result.get("schema") != SCHEMA:
+            sys.exit("%s: unsupported schema %r" % (path, result.get("schema")))
+
+    print("Baseline: %s (%s)" % (baseline["git"]["revision"], baseline["created"]))
+    print("Current:  %s (%s)" % (current["git"]["revision"], current["created"]))
+    for key in ("cpu_model", "cpus", "kernel"):
+        before, after = baseline["machine"].get(key), current["machine"].get(key)
+        if before != after:
+            print("Warning: %s differs (%s vs %s); the comparison may not be meaningful"
+                  % (key, before, after))
+    if baseline.get("settings") != current.get("settings"):
+        print("Warning: load generator settings differ between the runs")
+    print()
+
+    regressions = []
+    missing = []
+    width = max([len(n) for n in baseline["metrics"]] + [6])
+    print("%-*s %14s %14s %9s %6s  %s" % (width, "Metric", "Baseline", "Current", "Change", "Limit", ""))
+    for name in sorted(baseline["metrics"]):
+        before = baseline["metrics"][name]
+        after = current["metrics"].get(name)
+        if after is None:
+            missing.append(name)
+            continue
+        limit = tolerance_for(name, args)
+        b, a = float(before["value"]), float(after["value"])
+        if b == 0:
+            # Counts such as errors: any increase from zero is a regression
+            change = 0.0 if a == 0 else float("inf")
+        else:
+            change = (a - b) / abs(b) * 100
+        worse = change if before["better"] == "lower" else -change
+        status = ""
+        if worse > limit:
+            status = "REGRESSION"
+            regressions.append(name)
+        elif worse < -limit:
+            status = "improved"
+        print("%-*s %14.6g %14.6g %+8.1f%% %5.0f%%  %s" % (width, name, b, a, change, limit, status))
+
+    added = sorted(set(current["metrics"]) - set(baseline["metrics"]))
+    print()
+    if added:
+        print("%d metrics are new and not compared: %s" % (len(added), ", ".join(added)))
+    for error in current.get("errors", []):
+        print("Benchmark failed in the current run: %s" % error)
+    if missing:
+        print("%d baseline metrics are missing from the current run: %s" % (len(missing), ", ".join(missing)))
+    if regressions:
+        print("%d regressions beyond tolerance" % len(regressions))
+        return 1
+    if missing and not args.allow_missing:
+        print("Failing on missing metrics; pass --allow-missing to compare only what was measured")
+        return 1
+    print("No regressions beyond tolerance")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command")
+    commands.required = True
+
+    c = commands.add_parser("collect", help="merge raw benchmark output into one results file")
+    c.add_argument("--out", required=True, help="results file to write")
+    c.add_argument("--gbench", action="append", metavar="SUITE=FILE", help="Google Benchmark JSON output")
+    c.add_argument("--load", action="append", metavar="SCENARIO=FILE", help="benchmark_load --json output")
+    c.add_argument("--git-revision", default="unknown")
+    c.add_argument("--git-dirty", action="store_true", help="the tree had uncommitted changes")
+    c.add_argument("--label", default="", help="free-form note, e.g. the host role")
+    c.set_defaults(func=collect)
+
+    p = commands.add_parser("compare", help="compare a results file against a baseline")
+    p.add_argument("baseline")
+    p.add_argument("current")
+    p.add_argument("--tolerance", type=float, default=5.0,
+                   help="allowed change for the worse, in percent (default: 5)")
+    p.add_argument("--metric-tolerance", type=parse_metric_tolerance, action="append", default=[],
+                   metavar="PATTERN=PERCENT", help="override for metrics matching a glob; first match wins")
+    p.add_argument("--allow-missing", action="store_true",
+                   help="do not fail when a baseline metric was not measured or its benchmark errored")
+    p.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
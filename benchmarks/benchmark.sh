@@ -12,8 +12,26 @@ make -j$(nproc)
 # Run memory benchmarks  
 ./benchmarks/benchmark_memory --benchmark_time_unit=ms
 
+# Parser throughput per corpus (api_get, browser, post_body, pipelined, fragmented, mixed)
+./benchmarks/benchmark_parser
+
 # Run specific benchmark with filters
 ./benchmarks/benchmark_throughput --benchmark_filter="BM_RequestThroughput"
 
 # Run with detailed output
 ./benchmarks/benchmark_throughput --benchmark_format=json
+
+# End-to-end load: real sockets against an in-process server (or --connect HOST:PORT)
+./benchmarks/benchmark_load -t 4 -c 256 -d 30                 # closed loop, keep-alive
+./benchmarks/benchmark_load -t 4 -c 256 -p 16 -d 30           # pipelined
+./benchmarks/benchmark_load -t 4 -c 64 --no-keepalive -d 30   # connection per request
+./benchmarks/benchmark_load -t 4 -c 256 -r 50000 -d 30        # open loop at 50k req/s
+
+# C10K/C100K: memory per idle keep-alive connection and latency of an active set beside them
+# (needs a high `ulimit -n`: two descriptors per connection)
+./benchmarks/benchmark_connections -n 10000,50000,100000 -a 16 -d 10
+
+# Fixed-settings run of the suites and load scenarios into one JSON file (machine info, git revision),
+# then gate a change on a stored baseline (exit 1 on a regression beyond tolerance)
+../benchmarks/run_benchmarks.sh --build-dir . --out baseline.json
+../benchmarks/run_benchmarks.sh --build-dir . --baseline baseline.json --tolerance 5 --metric-tolerance 'load/*:latency_*=15'
@@ -0,0 +1,343 @@
+// Connection-scale benchmark (C10K/C100K). For each connection count it
+// starts a fresh in-process Server, opens that many keep-alive connections,
+// sends one request on each and leaves them idle, then reports the memory
+// they cost and the request latency of a small active set of connections
+// running next to them. Idle connections exercise the ConnectionPool shards
+// and the workers' periodic idle scan; both show up as memory per connection
+// and as tail latency on the active set.
+//
+// Every connection takes two descriptors in this process (client and
+// server side), so RLIMIT_NOFILE is raised as far as the hard limit allows
+// and the counts are capped to fit. Client sockets are spread over
+// 127.0.0.x source addresses to stay clear of ephemeral port exhaustion.
+#include "eventcore/server/server.h"
+#include "eventcore/core/logger.h"
+#include "eventcore/core/metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifndef IP_BIND_ADDRESS_NO_PORT
+#define IP_BIND_ADDRESS_NO_PORT 24
+#endif
+
+using eventcore::metrics::LatencyHistogram;
+
+namespace {
+
+    constexpr size_t kConnectionsPerSourceIp = 20000;
+
+    struct Options {
+        std::vector<size_t> counts = {10000, 50000, 100000};
+        size_t active = 16;        // Connections, one thread each, measured while the rest idle
+        double duration_s = 10;    // Longer than the 5 s idle scan period
+        size_t server_workers = 2;
+        size_t server_threads = 4;
+    };
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    size_t resident_bytes() {
+        std::ifstream statm("/proc/self/statm");
+        size_t pages = 0;
+        size_t resident = 0;
+        statm >> pages >> resident;
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    // Kernel socket buffer memory of all TCP sockets, from /proc/net/sockstat;
+    // idle connections whose buffers are drained cost close to none of it
+    size_t kernel_tcp_bytes() {
+        std::ifstream sockstat("/proc/net/sockstat");
+        std::string line;
+        while (std::getline(sockstat, line)) {
+            if (line.compare(0, 4, "TCP:") != 0) continue;
+            const size_t pos = line.find(" mem ");
+            if (pos == std::string::npos) return 0;
+            return std::strtoul(line.c_str() + pos + 5, nullptr, 10) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+        return 0;
+    }
+
+    size_t raise_fd_limit() {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return 1024;
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+        return limit.rlim_cur;
+    }
+
+    // Blocking client socket from 127.0.0.x, chosen by `index`
+    int connect_client(const eventcore::net::Address& target, size_t index) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        struct sockaddr_in source;
+        std::memset(&source, 0, sizeof(source));
+        source.sin_family = AF_INET;
+        source.sin_addr.s_addr = htonl(INADDR_LOOPBACK + static_cast<uint32_t>(index / kConnectionsPerSourceIp));
+        if (::bind(fd, reinterpret_cast<struct sockaddr*>(&source), sizeof(source)) != 0 ||
+                ::connect(fd, target.sockaddr(), target.socklen()) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        struct timeval tv = {5, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        return fd;
+    }
+
+    // Reads one Content-Length framed response; false on error or timeout
+    bool read_response(int fd, std::string& buf) {
+        buf.clear();
+        char chunk[4096];
+        size_t need = 0;
+        while (need == 0 || buf.size() < need) {
+            const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buf.append(chunk, static_cast<size_t>(n));
+            if (need == 0) {
+                const size_t head = buf.find("\r\n\r\n");
+                if (head == std::string::npos) continue;
+                const size_t cl = buf.find("Content-Length: ");
+                const size_t body = cl < head ? std::strtoul(buf.c_str() + cl + 16, nullptr, 10) : 0;
+                need = head + 4 + body;
+            }
+        }
+        return true;
+    }
+
+    bool write_all(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    std::unique_ptr<eventcore::server::Server> start_server(const Options& options, size_t connections) {
+        eventcore::server::Config config;
+        config.host = "127.0.0.1";
+        config.port = 0;
+        config.num_workers = options.server_workers;
+        config.num_threads_per_worker = options.server_threads;
+        config.connection_pool_size = connections + options.active + 1024;
+        config.max_connections = config.connection_pool_size;
+        // Idle connections must outlive the run
+        config.keepalive_timeout_sec = 3600;
+
+        auto server = std::make_unique<eventcore::server::Server>(config);
+        server->router().get("/hello", [](const eventcore::http::Request&) {
+                eventcore::http::Response resp;
+                resp.set_content_type("text/plain");
+                resp.set_body("Hello, World!");
+                return resp;
+                });
+        server->start();
+        return server;
+    }
+
+    struct ActiveResult {
+        LatencyHistogram::Snapshot latency;
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+    };
+
+    // `threads` blocking connections doing request/response round trips
+    ActiveResult run_active(const eventcore::net::Address& target, size_t threads, size_t first_index,
+            double duration_s) {
+        const std::string request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        LatencyHistogram latency;
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> errors{0};
+        const uint64_t end = now_ns() + static_cast<uint64_t>(duration_s * 1e9);
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                    const int fd = connect_client(target, first_index + t);
+                    if (fd < 0) {
+                        errors.fetch_add(1);
+                        return;
+                    }
+                    std::string buf;
+                    for (uint64_t start = now_ns(); start < end; start = now_ns()) {
+                        if (!write_all(fd, request) || !read_response(fd, buf)) {
+                            errors.fetch_add(1);
+                            break;
+                        }
+                        latency.record(now_ns() - start);
+                        requests.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    ::close(fd);
+                    });
+        }
+        for (auto& worker : workers) worker.join();
+
+        ActiveResult result;
+        latency.merge_into(&result.latency);
+        result.requests = requests.load();
+        result.errors = errors.load();
+        return result;
+    }
+
+    void run(const Options& options, size_t count) {
+        auto server = start_server(options, count);
+        const eventcore::net::Address target = server->local_address();
+        const size_t rss_before = resident_bytes();
+        const size_t kernel_before = kernel_tcp_bytes();
+        const std::string request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+        // Open, then warm every connection with one request so it holds the
+        // state a real keep-alive client leaves behind
+        const uint64_t open_start = now_ns();
+        std::vector<int> idle;
+        idle.reserve(count);
+        std::string buf;
+        for (size_t i = 0; i < count; ++i) {
+            const int fd = connect_client(target, i);
+            if (fd < 0) {
+                std::fprintf(stderr, "  connect %zu failed: %s\n", i, std::strerror(errno));
+                break;
+            }
+            idle.push_back(fd);
+            if (!write_all(fd, request) || !read_response(fd, buf)) {
+                std::fprintf(stderr, "  warm-up request %zu failed\n", i);
+                break;
+            }
+        }
+        const double open_s = static_cast<double>(now_ns() - open_start) / 1e9;
+
+        // Give the workers a moment to settle the last registrations
+        for (int i = 0; i < 100 && server->active_connections() < idle.size(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        const size_t opened = idle.size();
+        const size_t rss_idle = resident_bytes();
+        const size_t kernel_idle = kernel_tcp_bytes();
+        const eventcore::net::SlabPoolStats buffers = server->buffer_pool_stats();
+
+        const ActiveResult active = run_active(target, options.active, count, options.duration_s);
+
+        for (int fd : idle) ::close(fd);
+        server->stop();
+
+        const double per_conn = opened ? static_cast<double>(rss_idle > rss_before ? rss_idle - rss_before : 0) /
+            static_cast<double>(opened) : 0;
+        const double kernel_per_conn = opened ? static_cast<double>(
+                kernel_idle > kernel_before ? kernel_idle - kernel_before : 0) / static_cast<double>(opened) : 0;
+        const LatencyHistogram::Snapshot& snap = active.latency;
+        std::printf("%9zu %8.2f %10.0f %12.0f %10zu %10zu %10.0f %8.1f %8.1f %8.1f %9.1f %6llu\n",
+                opened, open_s, per_conn, kernel_per_conn, buffers.bytes_in_use(), buffers.bytes_cached(),
+                static_cast<double>(active.requests) / options.duration_s,
+                static_cast<double>(snap.quantile(0.5)) / 1e3, static_cast<double>(snap.quantile(0.99)) / 1e3,
+                static_cast<double>(snap.quantile(0.999)) / 1e3, static_cast<double>(snap.quantile(1.0)) / 1e3,
+                static_cast<unsigned long long>(active.errors));
+        std::fflush(stdout);
+    }
+
+    std::vector<size_t> parse_counts(const std::string& list) {
+        std::vector<size_t> counts;
+        std::stringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (!item.empty()) counts.push_back(std::stoul(item));
+        }
+        return counts;
+    }
+
+    void print_usage(const char* program_name) {
+        std::cout << "Usage: " << program_name << " [OPTIONS]\n"
+            << "Options:\n"
+            << "  -n, --connections LIST   Idle connection counts (default: 10000,50000,100000)\n"
+            << "  -a, --active NUM         Active connections measured alongside (default: 16)\n"
+            << "  -d, --duration SEC       Active phase length (default: 10)\n"
+            << "  --server-workers NUM     Server workers (default: 2)\n"
+            << "  --server-threads NUM     Server threads per worker (default: 4)\n"
+            << std::endl;
+    }
+
+    Options parse_command_line(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: " << arg << " requires an argument" << std::endl;
+                    std::exit(1);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "-h" || arg == "--help") {
+                print_usage(argv[0]);
+                std::exit(0);
+            } else if (arg == "-n" || arg == "--connections") {
+                options.counts = parse_counts(value());
+            } else if (arg == "-a" || arg == "--active") {
+                options.active = std::max<size_t>(std::stoul(value()), 1);
+            } else if (arg == "-d" || arg == "--duration") {
+                options.duration_s = std::stod(value());
+            } else if (arg == "--server-workers") {
+                options.server_workers = std::stoul(value());
+            } else if (arg == "--server-threads") {
+                options.server_threads = std::stoul(value());
+            } else {
+                std::cerr << "Error: Unknown option " << arg << std::endl;
+                print_usage(argv[0]);
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const Options options = parse_command_line(argc, argv);
+    eventcore::logging::Logger::instance().set_level(eventcore::logging::LogLevel::WARN);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Two descriptors per connection, plus headroom for the server itself
+    const size_t fd_limit = raise_fd_limit();
+    const size_t max_connections = fd_limit > 256 + 2 * options.active ? (fd_limit - 256) / 2 - options.active : 0;
+    std::printf("Server: %zu workers x %zu threads; %zu active connections for %.1f s; fd limit %zu\n\n",
+            options.server_workers, options.server_threads, options.active, options.duration_s, fd_limit);
+    std::printf("%9s %8s %10s %12s %10s %10s %10s %8s %8s %8s %9s %6s\n", "idle", "open s", "RSS B/conn",
+            "kbuf B/conn", "buf used", "buf cached", "req/s", "p50 us", "p99 us", "p99.9 us", "max us", "errors");
+
+    for (size_t count : options.counts) {
+        if (count > max_connections) {
+            std::fprintf(stderr, "%zu connections exceed the descriptor limit; running %zu\n", count, max_connections);
+            count = max_connections;
+        }
+        run(options, count);
+    }
+    return 0;
+}
@@ -0,0 +1,643 @@
+// End-to-end HTTP load generator. Drives a real Server (started in-process,
+// or any server given with --connect) over sockets from several epoll-based
+// client threads and reports requests/sec and latency percentiles.
+//
+// Closed loop (default): every connection keeps --pipeline requests in
+// flight and sends the next one as soon as a response arrives. Latency is
+// service time, so a server stall also stops the clock; the corrected row
+// back-fills the requests the stall kept from being sent, HdrHistogram-style,
+// at an expected interval of the median latency (or --expected-interval-us).
+//
+// Open loop (--rate): requests are scheduled at fixed intervals regardless
+// of how fast responses come back, and latency is measured from the
+// scheduled send time, so queueing behind a slow response is counted.
+#include "eventcore/server/server.h"
+#include "eventcore/core/logger.h"
+#include "eventcore/core/metrics.h"
+#include "eventcore/net/address.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using eventcore::metrics::LatencyHistogram;
+
+namespace {
+
+    struct Options {
+        std::string connect;          // host:port of an external server; empty starts one in-process
+        uint16_t server_port = 0;     // 0 binds an ephemeral port
+        size_t server_workers = 2;
+        size_t server_threads = 4;
+        size_t threads = 2;
+        size_t connections = 64;
+        size_t pipeline = 1;          // Requests in flight per connection
+        bool keep_alive = true;
+        double rate = 0;              // Requests/s over all connections; 0 runs a closed loop
+        double duration_s = 10;
+        double warmup_s = 1;
+        uint64_t expected_interval_ns = 0;
+        std::string path = "/hello";
+        std::string json_path;        // Also write the results here as JSON
+    };
+
+    struct Totals {
+        uint64_t completed = 0;       // Responses inside the measurement window
+        uint64_t non_2xx = 0;
+        uint64_t errors = 0;          // Failed connects, resets and requests lost with them
+        uint64_t connects = 0;
+        uint64_t bytes_read = 0;
+        uint64_t behind_schedule = 0; // Open loop: requests due but never sent
+
+        void add(const Totals& other) {
+            completed += other.completed;
+            non_2xx += other.non_2xx;
+            errors += other.errors;
+            connects += other.connects;
+            bytes_read += other.bytes_read;
+            behind_schedule += other.behind_schedule;
+        }
+    };
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool equals_ignore_case(const char* a, const char* b, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Length of the complete response at the front of [data, data + size),
+    // 0 while incomplete, -1 if it cannot be framed. Only Content-Length
+    // framing is understood, which is all the server produces.
+    long frame_response(const char* data, size_t size, int* status, bool* close) {
+        const char* end = static_cast<const char*>(memmem(data, size, "\r\n\r\n", 4));
+        if (!end) return 0;
+        const size_t head = static_cast<size_t>(end - data) + 4;
+        if (head < 12 || std::memcmp(data, "HTTP/1.", 7) != 0) return -1;
+        *status = std::atoi(data + 9);
+
+        size_t body = 0;
+        *close = false;
+        const char* line = static_cast<const char*>(std::memchr(data, '\n', head)) + 1;
+        while (line < end) {
+            const char* eol = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end + 2 - line)));
+            const size_t len = static_cast<size_t>(eol - line);
+            if (len > 15 && equals_ignore_case(line, "content-length:", 15)) {
+                body = std::strtoul(line + 15, nullptr, 10);
+            } else if (len > 11 && equals_ignore_case(line, "connection:", 11)) {
+                const char* value = line + 11;
+                while (*value == ' ') ++value;
+                *close = equals_ignore_case(value, "close", 5);
+            }
+            line = eol + 1;
+        }
+        return head + body <= size ? static_cast<long>(head + body) : 0;
+    }
+
+    class LoadThread {
+        public:
+            LoadThread(const Options& options, const eventcore::net::Address& target, size_t first, size_t count,
+                    uint64_t start_ns)
+                : options_(options), target_(target), clients_(count),
+                measure_ns_(start_ns + static_cast<uint64_t>(options.warmup_s * 1e9)),
+                end_ns_(measure_ns_ + static_cast<uint64_t>(options.duration_s * 1e9)) {
+                    request_ = "GET " + options.path + " HTTP/1.1\r\nHost: " + target.to_string() + "\r\n";
+                    if (!options.keep_alive) request_ += "Connection: close\r\n";
+                    request_ += "\r\n";
+                    pipeline_ = options.keep_alive ? std::max<size_t>(options.pipeline, 1) : 1;
+                    if (options.rate > 0) {
+                        interval_ns_ = static_cast<uint64_t>(static_cast<double>(options.connections) * 1e9 / options.rate);
+                        // Stagger the connections over one interval
+                        for (size_t i = 0; i < count; ++i) {
+                            clients_[i].next_send_ns = start_ns + interval_ns_ * (first + i) / options.connections;
+                        }
+                    }
+                }
+
+            ~LoadThread() {
+                for (auto& client : clients_) {
+                    if (client.fd >= 0) ::close(client.fd);
+                }
+                if (epoll_fd_ >= 0) ::close(epoll_fd_);
+            }
+
+            void run() {
+                epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+                if (epoll_fd_ < 0) {
+                    std::perror("epoll_create1");
+                    return;
+                }
+                for (size_t i = 0; i < clients_.size(); ++i) open(i, now_ns());
+
+                std::vector<struct epoll_event> events(256);
+                uint64_t now = now_ns();
+                while (now < end_ns_) {
+                    int timeout_ms = 10;
+                    if (interval_ns_ > 0) {
+                        // Sub-millisecond gaps are spun through rather than overslept
+                        const uint64_t next = next_due();
+                        timeout_ms = next <= now ? 0 : static_cast<int>(std::min<uint64_t>((next - now) / 1000000, 10));
+                    }
+                    const int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout_ms);
+                    now = now_ns();
+                    for (int i = 0; i < n; ++i) {
+                        handle_event(events[static_cast<size_t>(i)].data.u64, events[static_cast<size_t>(i)].events, now);
+                    }
+                    if (interval_ns_ > 0 || reconnects_pending_ > 0 || n == 0) {
+                        for (size_t i = 0; i < clients_.size(); ++i) service(i, now);
+                    }
+                }
+
+                if (interval_ns_ > 0) {
+                    for (const auto& client : clients_) {
+                        if (client.next_send_ns <= end_ns_) {
+                            totals_.behind_schedule += (end_ns_ - client.next_send_ns) / interval_ns_ + 1;
+                        }
+                    }
+                }
+            }
+
+            const Totals& totals() const { return totals_; }
+            const LatencyHistogram& latency() const { return latency_; }
+
+        private:
+            struct Client {
+                int fd = -1;
+                bool connected = false;
+                uint64_t retry_ns = 0;           // Reconnect no earlier than this after a failure
+                std::string out;
+                size_t out_sent = 0;
+                std::string in;
+                size_t in_parsed = 0;
+                std::deque<uint64_t> inflight;   // Start time of each outstanding request
+                uint64_t next_send_ns = 0;       // Open loop: when the next request is due
+            };
+
+            uint64_t next_due() const {
+                uint64_t next = UINT64_MAX;
+                for (const auto& client : clients_) {
+                    if (client.fd >= 0 && client.inflight.size() < pipeline_) next = std::min(next, client.next_send_ns);
+                }
+                return next;
+            }
+
+            void open(size_t index, uint64_t now) {
+                Client& client = clients_[index];
+                client.fd = ::socket(target_.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                if (client.fd < 0) {
+                    fail(index, now);
+                    return;
+                }
+                if (!target_.is_unix()) {
+                    int one = 1;
+                    setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                }
+                if (::connect(client.fd, target_.sockaddr(), target_.socklen()) < 0 && errno != EINPROGRESS) {
+                    fail(index, now);
+                    return;
+                }
+                struct epoll_event ev;
+                ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+                ev.data.u64 = index;
+                if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client.fd, &ev) < 0) {
+                    fail(index, now);
+                    return;
+                }
+                ++totals_.connects;
+                // Queued now and written once connected, so a closed loop without
+                // keep-alive charges the connect to the request's latency.
+                fill(client, now);
+            }
+
+            void close_client(Client& client) {
+                if (client.fd >= 0) ::close(client.fd);
+                client.fd = -1;
+                client.connected = false;
+                client.out.clear();
+                client.out_sent = 0;
+                client.in.clear();
+                client.in_parsed = 0;
+            }
+
+            // Requests lost with the connection count as errors; their schedule
+            // slots stay due, so an open loop re-sends them late, as it should.
+            void fail(size_t index, uint64_t now) {
+                Client& client = clients_[index];
+                totals_.errors += std::max<size_t>(client.inflight.size(), 1);
+                if (interval_ns_ > 0 && !client.inflight.empty()) client.next_send_ns = client.inflight.front();
+                client.inflight.clear();
+                close_client(client);
+                client.retry_ns = now + 10000000;
+                ++reconnects_pending_;
+            }
+
+            void fill(Client& client, uint64_t now) {
+                while (client.inflight.size() < pipeline_) {
+                    uint64_t start = now;
+                    if (interval_ns_ > 0) {
+                        if (client.next_send_ns > now) break;
+                        start = client.next_send_ns;
+                        client.next_send_ns += interval_ns_;
+                    }
+                    client.inflight.push_back(start);
+                    client.out += request_;
+                }
+            }
+
+            void service(size_t index, uint64_t now) {
+                Client& client = clients_[index];
+                if (client.fd < 0) {
+                    if (now >= client.retry_ns) {
+                        --reconnects_pending_;
+                        open(index, now);
+                    }
+                    return;
+                }
+                if (interval_ns_ > 0 && client.inflight.size() < pipeline_ && client.next_send_ns <= now) {
+                    fill(client, now);
+                    if (client.connected) flush(index, now);
+                }
+            }
+
+            void handle_event(uint64_t index, uint32_t events, uint64_t now) {
+                Client& client = clients_[index];
+                if (client.fd < 0) return;
+                if (!client.connected && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                    int err = 0;
+                    socklen_t len = sizeof(err);
+                    getsockopt(client.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                    if (err != 0) {
+                        fail(index, now);
+                        return;
+                    }
+                    client.connected = true;
+                }
+                if (!client.connected) return;
+                if (events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+                    if (!drain(index, now)) return;
+                }
+                flush(index, now);
+            }
+
+            void flush(size_t index, uint64_t now) {
+                Client& client = clients_[index];
+                while (client.out_sent < client.out.size()) {
+                    const ssize_t n = ::send(client.fd, client.out.data() + client.out_sent,
+                            client.out.size() - client.out_sent, MSG_NOSIGNAL);
+                    if (n < 0) {
+                        if (errno != EAGAIN && errno != EWOULDBLOCK) fail(index, now);
+                        return;
+                    }
+                    client.out_sent += static_cast<size_t>(n);
+                }
+                client.out.clear();
+                client.out_sent = 0;
+            }
+
+            // Reads and accounts every complete response; false once the client closed
+            bool drain(size_t index, uint64_t now) {
+                Client& client = clients_[index];
+                char buf[16384];
+                while (true) {
+                    const ssize_t n = ::read(client.fd, buf, sizeof(buf));
+                    if (n > 0) {
+                        totals_.bytes_read += static_cast<uint64_t>(n);
+                        client.in.append(buf, static_cast<size_t>(n));
+                        continue;
+                    }
+                    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                    // EOF or error: what was parsed so far still counts
+                    if (!consume(index, now) || client.fd < 0) return false;
+                    if (client.inflight.empty()) {
+                        close_client(client);
+                        client.retry_ns = now;
+                        ++reconnects_pending_;
+                    } else {
+                        fail(index, now);
+                    }
+                    return false;
+                }
+                return consume(index, now);
+            }
+
+            bool consume(size_t index, uint64_t now) {
+                Client& client = clients_[index];
+                while (client.in_parsed < client.in.size()) {
+                    int status = 0;
+                    bool close = false;
+                    const long size = frame_response(client.in.data() + client.in_parsed,
+                            client.in.size() - client.in_parsed, &status, &close);
+                    if (size == 0) break;
+                    if (size < 0 || client.inflight.empty()) {
+                        fail(index, now);
+                        return false;
+                    }
+                    client.in_parsed += static_cast<size_t>(size);
+
+                    const uint64_t start = client.inflight.front();
+                    client.inflight.pop_front();
+                    if (now >= measure_ns_ && now < end_ns_) {
+                        ++totals_.completed;
+                        if (status < 200 || status > 299) ++totals_.non_2xx;
+                        latency_.record(now - start);
+                    }
+
+                    if (close || !options_.keep_alive) {
+                        close_client(client);
+                        open(index, now);
+                        return false;
+                    }
+                }
+                if (client.in_parsed == client.in.size()) {
+                    client.in.clear();
+                    client.in_parsed = 0;
+                }
+                if (interval_ns_ == 0) fill(client, now);
+                return true;
+            }
+
+            const Options& options_;
+            eventcore::net::Address target_;
+            std::vector<Client> clients_;
+            std::string request_;
+            size_t pipeline_ = 1;
+            uint64_t interval_ns_ = 0;  // Per connection; 0 in a closed loop
+            uint64_t measure_ns_;
+            uint64_t end_ns_;
+            int epoll_fd_ = -1;
+            size_t reconnects_pending_ = 0;  // Clients without a socket, waiting to reconnect
+            Totals totals_;
+            LatencyHistogram latency_;
+    };
+
+    // Adds the samples a closed loop never took while it waited on a slow
+    // response: for a value v above the expected interval, v - interval,
+    // v - 2 * interval, ... down to the interval (HdrHistogram's
+    // copyCorrectedForCoordinatedOmission).
+    LatencyHistogram::Snapshot correct_for_omission(const LatencyHistogram::Snapshot& raw, uint64_t interval) {
+        LatencyHistogram::Snapshot corrected = raw;
+        if (interval == 0) return corrected;
+        for (size_t bucket = 0; bucket < LatencyHistogram::kBuckets; ++bucket) {
+            const uint64_t count = raw.counts[bucket];
+            if (count == 0) continue;
+            const uint64_t value = LatencyHistogram::bucket_upper(bucket);
+            for (uint64_t missing = value > interval ? value - interval : 0; missing >= interval; missing -= interval) {
+                corrected.counts[LatencyHistogram::bucket_of(missing)] += count;
+                corrected.count += count;
+                corrected.sum += missing * count;
+            }
+        }
+        return corrected;
+    }
+
+    void print_latency(const char* label, const LatencyHistogram::Snapshot& snap) {
+        const double mean = snap.count ? static_cast<double>(snap.sum) / static_cast<double>(snap.count) : 0;
+        std::printf("  %-10s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", label, mean / 1e3,
+                static_cast<double>(snap.quantile(0.5)) / 1e3, static_cast<double>(snap.quantile(0.9)) / 1e3,
+                static_cast<double>(snap.quantile(0.99)) / 1e3, static_cast<double>(snap.quantile(0.999)) / 1e3,
+                static_cast<double>(snap.quantile(0.9999)) / 1e3, static_cast<double>(snap.quantile(1.0)) / 1e3);
+    }
+
+    void write_json_latency(FILE* out, const char* name, const LatencyHistogram::Snapshot& snap, const char* separator) {
+        const double mean = snap.count ? static_cast<double>(snap.sum) / static_cast<double>(snap.count) : 0;
+        std::fprintf(out, "  \"%s\": {\"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+                "\"p999\": %.1f, \"p9999\": %.1f, \"max\": %.1f}%s\n", name, mean / 1e3,
+                static_cast<double>(snap.quantile(0.5)) / 1e3, static_cast<double>(snap.quantile(0.9)) / 1e3,
+                static_cast<double>(snap.quantile(0.99)) / 1e3, static_cast<double>(snap.quantile(0.999)) / 1e3,
+                static_cast<double>(snap.quantile(0.9999)) / 1e3, static_cast<double>(snap.quantile(1.0)) / 1e3, separator);
+    }
+
+    // Same numbers as the console report, for run_benchmarks.sh; latencies in us
+    bool write_json(const Options& options, const Totals& totals, const LatencyHistogram::Snapshot& raw,
+            const LatencyHistogram::Snapshot* corrected) {
+        FILE* out = std::fopen(options.json_path.c_str(), "w");
+        if (!out) return false;
+        std::fprintf(out, "{\n  \"settings\": {\"threads\": %zu, \"connections\": %zu, \"pipeline\": %zu, "
+                "\"keep_alive\": %s, \"rate\": %.0f, \"duration_s\": %.1f, \"warmup_s\": %.1f, "
+                "\"server_workers\": %zu, \"server_threads\": %zu, \"external_server\": %s},\n",
+                options.threads, options.connections, options.keep_alive ? options.pipeline : 1,
+                options.keep_alive ? "true" : "false", options.rate, options.duration_s, options.warmup_s,
+                options.server_workers, options.server_threads, options.connect.empty() ? "false" : "true");
+        std::fprintf(out, "  \"requests\": %llu,\n  \"requests_per_second\": %.1f,\n  \"mb_per_second\": %.2f,\n"
+                "  \"errors\": %llu,\n  \"non_2xx\": %llu,\n  \"connects\": %llu,\n  \"behind_schedule\": %llu,\n",
+                static_cast<unsigned long long>(totals.completed),
+                static_cast<double>(totals.completed) / options.duration_s,
+                static_cast<double>(totals.bytes_read) / (options.duration_s + options.warmup_s) / 1e6,
+                static_cast<unsigned long long>(totals.errors), static_cast<unsigned long long>(totals.non_2xx),
+                static_cast<unsigned long long>(totals.connects),
+                static_cast<unsigned long long>(totals.behind_schedule));
+        if (corrected) write_json_latency(out, "corrected_latency_us", *corrected, ",");
+        write_json_latency(out, "latency_us", raw, "");
+        std::fprintf(out, "}\n");
+        return std::fclose(out) == 0;
+    }
+
+    void print_usage(const char* program_name) {
+        std::cout << "Usage: " << program_name << " [OPTIONS]\n"
+            << "Target:\n"
+            << "  --connect HOST:PORT      Load an external server (default: start one in-process)\n"
+            << "  --server-port PORT       Port of the in-process server (default: ephemeral)\n"
+            << "  --server-workers NUM     In-process server workers (default: 2)\n"
+            << "  --server-threads NUM     In-process server threads per worker (default: 4)\n"
+            << "  --path PATH              Request path (default: /hello)\n"
+            << "Load:\n"
+            << "  -t, --threads NUM        Client threads (default: 2)\n"
+            << "  -c, --connections NUM    Connections over all threads (default: 64)\n"
+            << "  -p, --pipeline NUM       Requests in flight per connection (default: 1)\n"
+            << "  --no-keepalive           One request per connection\n"
+            << "  -r, --rate RPS           Open loop at RPS requests/s in total (default: closed loop)\n"
+            << "  -d, --duration SEC       Measured duration (default: 10)\n"
+            << "  --warmup SEC             Unmeasured warm-up (default: 1)\n"
+            << "  --expected-interval-us N Closed-loop omission correction interval (default: median)\n"
+            << "Output:\n"
+            << "  --json FILE              Also write the results to FILE as JSON\n"
+            << std::endl;
+    }
+
+    Options parse_command_line(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: " << arg << " requires an argument" << std::endl;
+                    std::exit(1);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "-h" || arg == "--help") {
+                print_usage(argv[0]);
+                std::exit(0);
+            } else if (arg == "--connect") {
+                options.connect = value();
+            } else if (arg == "--server-port") {
+                options.server_port = static_cast<uint16_t>(std::stoi(value()));
+            } else if (arg == "--server-workers") {
+                options.server_workers = std::stoul(value());
+            } else if (arg == "--server-threads") {
+                options.server_threads = std::stoul(value());
+            } else if (arg == "--path") {
+                options.path = value();
+            } else if (arg == "-t" || arg == "--threads") {
+                options.threads = std::max<size_t>(std::stoul(value()), 1);
+            } else if (arg == "-c" || arg == "--connections") {
+                options.connections = std::max<size_t>(std::stoul(value()), 1);
+            } else if (arg == "-p" || arg == "--pipeline") {
+                options.pipeline = std::max<size_t>(std::stoul(value()), 1);
+            } else if (arg == "--no-keepalive") {
+                options.keep_alive = false;
+            } else if (arg == "-r" || arg == "--rate") {
+                options.rate = std::stod(value());
+            } else if (arg == "-d" || arg == "--duration") {
+                options.duration_s = std::stod(value());
+            } else if (arg == "--warmup") {
+                options.warmup_s = std::stod(value());
+            } else if (arg == "--expected-interval-us") {
+                options.expected_interval_ns = std::stoull(value()) * 1000;
+            } else if (arg == "--json") {
+                options.json_path = value();
+            } else {
+                std::cerr << "Error: Unknown option " << arg << std::endl;
+                print_usage(argv[0]);
+                std::exit(1);
+            }
+        }
+        options.threads = std::min(options.threads, options.connections);
+        return options;
+    }
+
+    std::unique_ptr<eventcore::server::Server> start_server(const Options& options) {
+        eventcore::server::Config config;
+        config.host = "127.0.0.1";
+        config.port = options.server_port;
+        config.num_workers = options.server_workers;
+        config.num_threads_per_worker = options.server_threads;
+        config.connection_pool_size = std::max<size_t>(options.connections * 2, 1024);
+
+        auto server = std::make_unique<eventcore::server::Server>(config);
+        server->router().get("/hello", [](const eventcore::http::Request&) {
+                eventcore::http::Response resp;
+                resp.set_content_type("text/plain");
+                resp.set_body("Hello, World!");
+                return resp;
+                });
+        server->router().get("/json", [](const eventcore::http::Request&) {
+                return eventcore::http::Response::make_json(200, R"({"message": "Hello", "status": "ok"})");
+                });
+        server->start();
+        return server;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const Options options = parse_command_line(argc, argv);
+    eventcore::logging::Logger::instance().set_level(eventcore::logging::LogLevel::WARN);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::unique_ptr<eventcore::server::Server> server;
+    eventcore::net::Address target;
+    if (options.connect.empty()) {
+        server = start_server(options);
+        target = server->local_address();
+    } else {
+        auto parsed = eventcore::net::Address::parse(options.connect);
+        if (parsed.is_err()) {
+            std::cerr << "Invalid --connect address: " << parsed.error() << std::endl;
+            return 1;
+        }
+        target = parsed.value();
+    }
+
+    std::printf("Target:  %s%s (%s)\n", target.to_string().c_str(), options.path.c_str(),
+            server ? "in-process server" : "external server");
+    if (server) {
+        std::printf("Server:  %zu workers x %zu threads\n", options.server_workers, options.server_threads);
+    }
+    std::printf("Load:    %s, %zu connections on %zu threads, pipeline %zu, %s\n",
+            options.rate > 0 ? "open loop" : "closed loop", options.connections, options.threads,
+            options.keep_alive ? options.pipeline : 1, options.keep_alive ? "keep-alive" : "no keep-alive");
+    if (options.rate > 0) std::printf("Rate:    %.0f requests/s\n", options.rate);
+    std::printf("Running: %.1f s after %.1f s warm-up\n", options.duration_s, options.warmup_s);
+    std::fflush(stdout);
+
+    const uint64_t start_ns = now_ns();
+    std::vector<std::unique_ptr<LoadThread>> loaders;
+    std::vector<std::thread> threads;
+    size_t first = 0;
+    for (size_t t = 0; t < options.threads; ++t) {
+        const size_t count = options.connections / options.threads + (t < options.connections % options.threads ? 1 : 0);
+        loaders.push_back(std::make_unique<LoadThread>(options, target, first, count, start_ns));
+        first += count;
+    }
+    for (auto& loader : loaders) {
+        threads.emplace_back([&loader]() { loader->run(); });
+    }
+    for (auto& thread : threads) thread.join();
+    if (server) server->stop();
+
+    Totals totals;
+    LatencyHistogram::Snapshot raw;
+    for (const auto& loader : loaders) {
+        totals.add(loader->totals());
+        loader->latency().merge_into(&raw);
+    }
+
+    std::printf("\nRequests: %llu (%.1f req/s), %.2f MB/s read\n",
+            static_cast<unsigned long long>(totals.completed),
+            static_cast<double>(totals.completed) / options.duration_s,
+            static_cast<double>(totals.bytes_read) / (options.duration_s + options.warmup_s) / 1e6);
+    std::printf("Errors:   %llu, non-2xx: %llu, connects: %llu\n",
+            static_cast<unsigned long long>(totals.errors), static_cast<unsigned long long>(totals.non_2xx),
+            static_cast<unsigned long long>(totals.connects));
+    if (options.rate > 0 && totals.behind_schedule > 0) {
+        std::printf("Behind:   %llu requests were due but never sent; the target rate was not sustained\n",
+                static_cast<unsigned long long>(totals.behind_schedule));
+    }
+
+    std::printf("\nLatency (us) %9s %9s %9s %9s %9s %9s %9s\n", "mean", "p50", "p90", "p99", "p99.9", "p99.99", "max");
+    LatencyHistogram::Snapshot corrected;
+    if (options.rate > 0) {
+        // Measured from the scheduled send time, which already accounts for omission
+        print_latency("scheduled", raw);
+    } else {
+        const uint64_t interval = options.expected_interval_ns ? options.expected_interval_ns : raw.quantile(0.5);
+        corrected = correct_for_omission(raw, interval);
+        print_latency("raw", raw);
+        print_latency("corrected", corrected);
+        std::printf("  (corrected for coordinated omission at an expected interval of %.1f us)\n",
+                static_cast<double>(interval) / 1e3);
+    }
+
+    if (!options.json_path.empty() &&
+            !write_json(options, totals, raw, options.rate > 0 ? nullptr : &corrected)) {
+        std::cerr << "Failed to write " << options.json_path << std::endl;
+        return 1;
+    }
+    return totals.completed > 0 ? 0 : 1;
+}
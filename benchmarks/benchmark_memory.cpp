@@ -1,12 +1,59 @@
 #include <benchmark/benchmark.h>
+#include "eventcore/core/alloc_counter.h"
 #include "eventcore/server/server.h"
+#include "eventcore/http/parser.h"
 #include "eventcore/http/router.h"
 #include "eventcore/net/buffer.h"
 #include "eventcore/thread/thread_pool.h"
 #include <memory>
 #include <vector>
 
-// Memory usage benchmarks for EventCore components
+// Memory usage benchmarks for EventCore components.
+//
+// Configure with -DEVENTCORE_ALLOC_COUNTING=ON to report the heap allocations
+// each iteration really makes (Allocs, AllocBytes) rather than estimates.
+
+static void report_allocations(benchmark::State& state, const eventcore::alloc::Scope& scope) {
+    if (!eventcore::alloc::counting_enabled()) return;
+    const auto delta = scope.delta();
+    state.counters["Allocs"] = benchmark::Counter(
+            static_cast<double>(delta.allocations), benchmark::Counter::kAvgIterations);
+    state.counters["AllocBytes"] = benchmark::Counter(
+            static_cast<double>(delta.bytes), benchmark::Counter::kAvgIterations);
+}
+
+// One keep-alive request end to end: parse, route, serialize. The buffers,
+// request and parser are reused as a connection reuses them, so in steady
+// state only the handler's response should allocate.
+static void BM_RequestPathAllocations(benchmark::State& state) {
+    eventcore::http::Router router;
+    router.get("/api/users/:id", [](const eventcore::http::Request&) {
+            return eventcore::http::Response::make_json(200, R"({"id": 1, "name": "user"})");
+            });
+    const std::string input =
+        "GET /api/users/1 HTTP/1.1\r\nHost: localhost\r\nUser-Agent: bench\r\nAccept: */*\r\n\r\n";
+
+    eventcore::net::Buffer in;
+    eventcore::net::Buffer out;
+    eventcore::http::Request request;
+    eventcore::http::Parser parser;
+    auto handle = [&] {
+        in.append(input);
+        parser.parse_request(&in, &request);
+        router.route(request).serialize(&out);
+        out.retrieve_all();
+        request.reset();
+        parser.reset();
+    };
+    handle();
+
+    eventcore::alloc::Scope scope;
+    for (auto _ : state) {
+        handle();
+    }
+    report_allocations(state, scope);
+}
+BENCHMARK(BM_RequestPathAllocations);
 
 static void BM_BufferMemoryUsage(benchmark::State& state) {
     const size_t buffer_size = state.range(0);
@@ -15,14 +62,15 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
     size_t total_memory = 0;
     size_t allocation_count = 0;
 
+    eventcore::alloc::Scope scope;
     for (auto _ : state) {
         eventcore::net::Buffer buffer;
 
         // Measure memory after appending data
         buffer.append(data);
 
-        // Estimate memory usage (this is approximate)
-        size_t estimated_memory = buffer_size + eventcore::net::Buffer::kPrependSize;
+        // Slab memory held by the buffer
+        size_t estimated_memory = buffer.capacity();
         total_memory += estimated_memory;
         allocation_count++;
 
@@ -33,6 +81,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
             total_memory / allocation_count, benchmark::Counter::kAvgThreads);
     state.counters["MemoryBandwidth"] = benchmark::Counter(
             total_memory, benchmark::Counter::kIsRate);
+    report_allocations(state, scope);
 }
 
     BENCHMARK(BM_BufferMemoryUsage)
@@ -46,6 +95,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
     static void BM_ConnectionMemoryOverhead(benchmark::State& state) {
         const int num_connections = state.range(0);
 
+        eventcore::alloc::Scope scope;
         for (auto _ : state) {
             std::vector<std::shared_ptr<eventcore::http::Connection>> connections;
             connections.reserve(num_connections);
@@ -68,11 +118,10 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
 
             benchmark::DoNotOptimize(connections.size());
 
-            // Memory measurement would typically be done with external tools
-            // For this benchmark, we just track the count
             state.counters["Connections"] = benchmark::Counter(
                     connections.size(), benchmark::Counter::kDefaults);
         }
+        report_allocations(state, scope);
     }
 
     BENCHMARK(BM_ConnectionMemoryOverhead)
@@ -130,6 +179,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
     static void BM_RouterMemoryUsage(benchmark::State& state) {
         const int num_routes = state.range(0);
 
+        eventcore::alloc::Scope scope;
         for (auto _ : state) {
             eventcore::http::Router router;
 
@@ -162,6 +212,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
 
             state.counters["Routes"] = benchmark::Counter(num_routes * 2, benchmark::Counter::kDefaults); // GET + POST
         }
+        report_allocations(state, scope);
     }
 
     BENCHMARK(BM_RouterMemoryUsage)
@@ -174,6 +225,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
     static void BM_ServerStartupMemory(benchmark::State& state) {
         const int num_workers = state.range(0);
 
+        eventcore::alloc::Scope scope(true);  // Workers and their pools allocate too
         for (auto _ : state) {
             eventcore::server::Config config;
             config.num_workers = num_workers;
@@ -198,6 +250,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
             state.counters["Workers"] = benchmark::Counter(num_workers, benchmark::Counter::kDefaults);
             state.counters["ThreadsPerWorker"] = benchmark::Counter(state.range(1), benchmark::Counter::kDefaults);
         }
+        report_allocations(state, scope);
     }
 
     BENCHMARK(BM_ServerStartupMemory)
@@ -252,6 +305,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
         const int body_size = state.range(0);
         const int header_count = state.range(1);
 
+        eventcore::alloc::Scope scope;
         for (auto _ : state) {
             eventcore::http::Response resp;
             resp.set_status(200, "OK");
@@ -274,6 +328,7 @@ static void BM_BufferMemoryUsage(benchmark::State& state) {
             state.counters["HeaderCount"] = benchmark::Counter(header_count, benchmark::Counter::kDefaults);
             state.counters["ResponseSize"] = benchmark::Counter(response_str.size(), benchmark::Counter::kDefaults);
         }
+        report_allocations(state, scope);
     }
 
     BENCHMARK(BM_ResponseMemory)
@@ -0,0 +1,184 @@
+#include <benchmark/benchmark.h>
+#include "eventcore/http/parser.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// http::Parser throughput over a corpus of realistic requests rather than one
+// synthetic request. Each sample is delivered as the chunks a socket might
+// return, parsed with a reused parser and request as a connection does, and
+// reported as bytes/s and requests/s (items).
+
+namespace {
+
+    struct Sample {
+        std::vector<std::string> chunks;
+        size_t requests = 0;
+        size_t bytes = 0;
+    };
+
+    enum CorpusKind { kApiGet, kBrowser, kPostBody, kPipelined, kFragmented, kMixed };
+    const char* const kCorpusNames[] = {"api_get", "browser", "post_body", "pipelined", "fragmented", "mixed"};
+    constexpr size_t kSamplesPerCorpus = 64;
+
+    std::string random_token(std::mt19937& rng, size_t size) {
+        static const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+        std::uniform_int_distribution<size_t> pick(0, sizeof(kAlphabet) - 2);
+        std::string out(size, 'x');
+        for (auto& c : out) c = kAlphabet[pick(rng)];
+        return out;
+    }
+
+    size_t between(std::mt19937& rng, size_t lo, size_t hi) {
+        return std::uniform_int_distribution<size_t>(lo, hi)(rng);
+    }
+
+    // GET /api/v1/users/123?fields=... with the handful of headers API clients send
+    std::string api_get(std::mt19937& rng) {
+        return "GET /api/v1/" + random_token(rng, between(rng, 4, 10)) + "/" + std::to_string(between(rng, 1, 99999)) +
+            "?fields=" + random_token(rng, between(rng, 4, 16)) + " HTTP/1.1\r\n"
+            "Host: api.example.com\r\n"
+            "User-Agent: okhttp/4.12.0\r\n"
+            "Accept: application/json\r\n"
+            "Authorization: Bearer " + random_token(rng, 40) + "\r\n"
+            "\r\n";
+    }
+
+    // A page load from a desktop browser, with 1-4 KB of cookies
+    std::string browser(std::mt19937& rng) {
+        std::string cookies;
+        const size_t cookie_bytes = between(rng, 1024, 4096);
+        while (cookies.size() < cookie_bytes) {
+            if (!cookies.empty()) cookies += "; ";
+            cookies += random_token(rng, between(rng, 3, 12)) + "=" + random_token(rng, between(rng, 8, 120));
+        }
+        return "GET /" + random_token(rng, between(rng, 5, 30)) + "/index.html HTTP/1.1\r\n"
+            "Host: www.example.com\r\n"
+            "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+            "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+            "Accept-Language: en-US,en;q=0.5\r\n"
+            "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+            "Referer: https://www.example.com/" + random_token(rng, 12) + "\r\n"
+            "Cookie: " + cookies + "\r\n"
+            "Upgrade-Insecure-Requests: 1\r\n"
+            "Sec-Fetch-Dest: document\r\n"
+            "Sec-Fetch-Mode: navigate\r\n"
+            "Sec-Fetch-Site: same-origin\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n";
+    }
+
+    // JSON POST with a 64 B - 8 KB body
+    std::string post_body(std::mt19937& rng) {
+        std::string body = "{\"items\": [";
+        const size_t body_bytes = between(rng, 64, 8192);
+        while (body.size() < body_bytes) {
+            if (body.back() != '[') body += ", ";
+            body += "{\"id\": " + std::to_string(between(rng, 1, 1000000)) + ", \"name\": \"" +
+                random_token(rng, between(rng, 4, 24)) + "\"}";
+        }
+        body += "]}";
+        return "POST /api/v1/orders HTTP/1.1\r\n"
+            "Host: api.example.com\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n" + body;
+    }
+
+    std::string request_of(CorpusKind kind, std::mt19937& rng) {
+        switch (kind) {
+            case kBrowser: return browser(rng);
+            case kPostBody: return post_body(rng);
+            default: return api_get(rng);
+        }
+    }
+
+    Sample whole(std::string data, size_t requests) {
+        Sample sample;
+        sample.bytes = data.size();
+        sample.requests = requests;
+        sample.chunks.push_back(std::move(data));
+        return sample;
+    }
+
+    // Cuts at random points, as partial reads deliver them
+    Sample fragmented(const std::string& data, std::mt19937& rng) {
+        Sample sample;
+        sample.bytes = data.size();
+        sample.requests = 1;
+        for (size_t at = 0; at < data.size(); ) {
+            const size_t size = std::min(between(rng, 1, 256), data.size() - at);
+            sample.chunks.push_back(data.substr(at, size));
+            at += size;
+        }
+        return sample;
+    }
+
+    Sample make_sample(CorpusKind kind, std::mt19937& rng) {
+        switch (kind) {
+            case kPipelined: {
+                // A batch of 16 small requests in one read
+                std::string batch;
+                for (int i = 0; i < 16; ++i) batch += api_get(rng);
+                return whole(std::move(batch), 16);
+            }
+            case kFragmented:
+                return fragmented(request_of(static_cast<CorpusKind>(between(rng, kApiGet, kPostBody)), rng), rng);
+            case kMixed:
+                return make_sample(static_cast<CorpusKind>(between(rng, kApiGet, kFragmented)), rng);
+            default:
+                return whole(request_of(kind, rng), 1);
+        }
+    }
+
+    std::vector<Sample> make_corpus(CorpusKind kind) {
+        std::mt19937 rng(static_cast<uint32_t>(kind) + 1);
+        std::vector<Sample> corpus;
+        for (size_t i = 0; i < kSamplesPerCorpus; ++i) corpus.push_back(make_sample(kind, rng));
+        return corpus;
+    }
+
+} // namespace
+
+static void BM_ParserCorpus(benchmark::State& state) {
+    const CorpusKind kind = static_cast<CorpusKind>(state.range(0));
+    const std::vector<Sample> corpus = make_corpus(kind);
+    state.SetLabel(kCorpusNames[kind]);
+
+    eventcore::net::Buffer buffer;
+    eventcore::http::Request request;
+    eventcore::http::Parser parser;
+    size_t bytes = 0;
+    size_t requests = 0;
+
+    for (auto _ : state) {
+        for (const Sample& sample : corpus) {
+            size_t parsed = 0;
+            for (const std::string& chunk : sample.chunks) {
+                buffer.append(chunk);
+                while (parser.parse_request(&buffer, &request)) {
+                    benchmark::DoNotOptimize(request.body().data());
+                    ++parsed;
+                    request.reset();
+                    parser.reset();
+                }
+            }
+            if (parsed != sample.requests || parser.has_error()) {
+                state.SkipWithError("Corpus sample did not parse");
+                return;
+            }
+            bytes += sample.bytes;
+            requests += parsed;
+        }
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(static_cast<int64_t>(requests));
+}
+
+BENCHMARK(BM_ParserCorpus)->DenseRange(kApiGet, kMixed)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -10,6 +10,7 @@ class EventCoreFixture : public benchmark::Fixture {
     public:
         void SetUp(const benchmark::State& state) override {
             // Configure server
+            config_.host = "127.0.0.1";
             config_.port = 0; // Let OS choose port
             config_.num_workers = state.range(0);
             config_.num_threads_per_worker = state.range(1);
@@ -42,9 +43,7 @@ class EventCoreFixture : public benchmark::Fixture {
                     });
 
             server_->start();
-
-            // Get actual port (in real implementation, you'd need to expose this)
-            port_ = 8080; // For demo purposes
+            port_ = server_->local_address().port();
         }
 
         void TearDown(const benchmark::State& state) override {
@@ -0,0 +1,204 @@
+#!/bin/bash
+#
+# EventCore Benchmark Driver
+# Runs the benchmark suites and the load generator with fixed settings,
+# writes one JSON results file (machine info, git revision, every metric)
+# and optionally compares it against a stored baseline.
+#
+
+set -e  # Exit on error
+
+# -------------------------------
+# Configuration
+# -------------------------------
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+SOURCE_DIR="$(dirname "$SCRIPT_DIR")"
+BUILD_DIR="$SOURCE_DIR/build"
+OUT="benchmark-results.json"
+BASELINE=""
+TOLERANCE=5
+METRIC_TOLERANCES=()
+COMPARE_ARGS=()
+REPETITIONS=3
+LOAD_DURATION=10
+LOAD_WARMUP=2
+LABEL=""
+
+# -------------------------------
+# Color codes
+# -------------------------------
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+# -------------------------------
+# Functions
+# -------------------------------
+
+print_msg() {
+    local color=$1
+    shift
+    echo -e "${color}$@${NC}"
+}
+
+usage() {
+    cat << EOF
+Usage: $0 [OPTIONS]
+
+Runs benchmark_throughput, benchmark_memory, benchmark_parser and fixed
+benchmark_load scenarios from a build configured with -DBUILD_BENCHMARKS=ON.
+
+Options:
+  --build-dir DIR           Build directory (default: $BUILD_DIR)
+  --out FILE                Results file (default: $OUT)
+  --baseline FILE           Compare against this results file; exit 1 on regression
+  --tolerance PCT           Allowed change for the worse, in percent (default: $TOLERANCE)
+  --metric-tolerance P=PCT  Tolerance for metrics matching glob P, e.g. 'load/*:latency_p99_us=20'
+  --allow-missing           Do not fail when a baseline metric was not measured
+                            (a suite was skipped or a benchmark errored)
+  --repetitions N           Google Benchmark repetitions; medians are kept (default: $REPETITIONS)
+  --duration SEC            Measured seconds per load scenario (default: $LOAD_DURATION)
+  --label TEXT              Note stored with the results, e.g. the host role
+  --quick                   One repetition and short load runs, to check the setup
+  --help                    Show this help
+
+Examples:
+  $0 --out baseline.json                          # Record a baseline
+  $0 --baseline baseline.json                     # Gate a change on it
+  $0 --baseline baseline.json --tolerance 10 --metric-tolerance 'load/*=15'
+
+Compare two stored results without rerunning:
+  $SCRIPT_DIR/bench_results.py compare baseline.json results.json
+EOF
+    exit 0
+}
+
+# -------------------------------
+# Parse command line arguments
+# -------------------------------
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        --build-dir)
+            BUILD_DIR="$2"
+            shift 2
+            ;;
+        --out)
+            OUT="$2"
+            shift 2
+            ;;
+        --baseline)
+            BASELINE="$2"
+            shift 2
+            ;;
+        --tolerance)
+            TOLERANCE="$2"
+            shift 2
+            ;;
+        --metric-tolerance)
+            METRIC_TOLERANCES+=(--metric-tolerance "$2")
+            shift 2
+            ;;
+        --allow-missing)
+            COMPARE_ARGS+=(--allow-missing)
+            shift
+            ;;
+        --repetitions)
+            REPETITIONS="$2"
+            shift 2
+            ;;
+        --duration)
+            LOAD_DURATION="$2"
+            shift 2
+            ;;
+        --label)
+            LABEL="$2"
+            shift 2
+            ;;
+        --quick)
+            REPETITIONS=1
+            LOAD_DURATION=2
+            LOAD_WARMUP=0.5
+            shift
+            ;;
+        --help|-h)
+            usage
+            ;;
+        *)
+            print_msg $RED "Unknown option: $1"
+            usage
+            ;;
+    esac
+done
+
+BENCH_DIR="$BUILD_DIR/bin/benchmarks"
+if [ ! -x "$BENCH_DIR/benchmark_load" ]; then
+    print_msg $RED "No benchmarks in $BENCH_DIR; configure with -DBUILD_BENCHMARKS=ON and build first"
+    exit 1
+fi
+if [ -n "$BASELINE" ] && [ ! -f "$BASELINE" ]; then
+    print_msg $RED "Baseline $BASELINE does not exist"
+    exit 1
+fi
+
+RAW_DIR=$(mktemp -d)
+trap 'rm -rf "$RAW_DIR"' EXIT
+COLLECT_ARGS=()
+
+# -------------------------------
+# Google Benchmark suites
+# -------------------------------
+for suite in throughput memory parser; do
+    binary="$BENCH_DIR/benchmark_$suite"
+    if [ ! -x "$binary" ]; then
+        print_msg $YELLOW "Skipping $suite: $binary not built (Google Benchmark missing?)"
+        continue
+    fi
+    print_msg $BLUE "Running benchmark_$suite ($REPETITIONS repetitions)..."
+    "$binary" \
+        --benchmark_repetitions="$REPETITIONS" \
+        --benchmark_report_aggregates_only=true \
+        --benchmark_out="$RAW_DIR/$suite.json" \
+        --benchmark_out_format=json
+    COLLECT_ARGS+=(--gbench "$suite=$RAW_DIR/$suite.json")
+done
+
+# -------------------------------
+# Load generator scenarios
+# -------------------------------
+run_load() {
+    local scenario=$1
+    shift
+    print_msg $BLUE "Running load scenario $scenario (${LOAD_DURATION}s)..."
+    "$BENCH_DIR/benchmark_load" -d "$LOAD_DURATION" --warmup "$LOAD_WARMUP" \
+        --json "$RAW_DIR/load-$scenario.json" "$@"
+    COLLECT_ARGS+=(--load "$scenario=$RAW_DIR/load-$scenario.json")
+}
+
+run_load keepalive -t 2 -c 64
+run_load pipelined -t 2 -c 64 -p 16
+run_load no_keepalive -t 2 -c 16 --no-keepalive
+
+# -------------------------------
+# Results
+# -------------------------------
+REVISION=$(git -C "$SOURCE_DIR" rev-parse HEAD 2>/dev/null || echo unknown)
+if [ -n "$(git -C "$SOURCE_DIR" status --porcelain --untracked-files=no 2>/dev/null)" ]; then
+    COLLECT_ARGS+=(--git-dirty)
+    print_msg $YELLOW "Working tree has uncommitted changes; results are marked dirty"
+fi
+
+python3 "$SCRIPT_DIR/bench_results.py" collect --out "$OUT" \
+    --git-revision "$REVISION" --label "$LABEL" "${COLLECT_ARGS[@]}"
+
+if [ -n "$BASELINE" ]; then
+    echo ""
+    if python3 "$SCRIPT_DIR/bench_results.py" compare "$BASELINE" "$OUT" \
+            --tolerance "$TOLERANCE" "${METRIC_TOLERANCES[@]}" "${COMPARE_ARGS[@]}"; then
+        print_msg $GREEN "No regressions against $BASELINE"
+    else
+        print_msg $RED "Regressions against $BASELINE"
+        exit 1
+    fi
+fi
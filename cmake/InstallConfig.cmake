@@ -21,7 +21,7 @@ if(BUILD_SHARED_LIBS)
 endif()
 
 # Install executable
-install(TARGETS eventcore_server
+install(TARGETS eventcore_server eventcore_trace2json
     RUNTIME DESTINATION ${CMAKE_INSTALL_BINDIR}
 )
 
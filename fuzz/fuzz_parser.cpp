@@ -0,0 +1,116 @@
+// Fuzz target for http::Parser. Each input is parsed three times: in one
+// piece, one byte at a time and in chunks cut at pseudo-random points derived
+// from the input. All three must agree on every request (or error) they
+// produce, so a fast path that only handles whole lines cannot diverge from
+// the incremental one unnoticed. Tight limits keep the 414/431/413 paths hot.
+#include "eventcore/http/parser.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using eventcore::http::Parser;
+using eventcore::http::ParserLimits;
+using eventcore::http::Request;
+
+namespace {
+
+    ParserLimits fuzz_limits() {
+        ParserLimits limits;
+        limits.max_request_line = 256;
+        limits.max_header_count = 16;
+        limits.max_header_bytes = 1024;
+        limits.max_body_size = 4096;
+        return limits;
+    }
+
+    std::string describe(const Request& request) {
+        std::string out = Request::method_to_string(request.method());
+        out += ' ';
+        out += request.path();
+        out += '?';
+        out += request.query();
+        out += ' ';
+        out += std::to_string(static_cast<int>(request.version()));
+        for (const auto& field : request.headers()) {
+            out += '\n';
+            out += field.name_string();
+            out += ':';
+            out += field.value_string();
+        }
+        out += "\n\n";
+        out += request.body();
+        return out;
+    }
+
+    // Requests parsed, then "error N" or "pending" for the state the input ends in
+    std::vector<std::string> parse_in_chunks(const uint8_t* data, size_t size, const std::vector<size_t>& cuts) {
+        std::vector<std::string> outcomes;
+        eventcore::net::Buffer buffer;
+        Request request;
+        Parser parser(fuzz_limits());
+
+        size_t offset = 0;
+        for (size_t i = 0; i <= cuts.size() && !parser.has_error(); ++i) {
+            const size_t end = i < cuts.size() ? cuts[i] : size;
+            buffer.append(data + offset, end - offset);
+            offset = end;
+            while (parser.parse_request(&buffer, &request)) {
+                if (request.method() == eventcore::http::Method::UNKNOWN) {
+                    std::fprintf(stderr, "parsed a request with an unknown method\n");
+                    std::abort();
+                }
+                outcomes.push_back(describe(request));
+                request.reset();
+                parser.reset();
+            }
+        }
+
+        if (parser.has_error()) {
+            const int status = parser.error_status();
+            if (status != 400 && status != 413 && status != 414 && status != 431) {
+                std::fprintf(stderr, "unexpected error status %d\n", status);
+                std::abort();
+            }
+            outcomes.push_back("error " + std::to_string(status));
+        } else {
+            outcomes.push_back("pending");
+        }
+        return outcomes;
+    }
+
+    void expect_same(const std::vector<std::string>& expected, const std::vector<std::string>& actual, const char* delivery) {
+        if (expected == actual) return;
+        std::fprintf(stderr, "%s delivery diverged: %zu outcomes whole, %zu %s\n",
+                delivery, expected.size(), actual.size(), delivery);
+        for (size_t i = 0; i < expected.size() || i < actual.size(); ++i) {
+            std::fprintf(stderr, "--- %zu whole:\n%s\n--- %zu %s:\n%s\n", i,
+                    i < expected.size() ? expected[i].c_str() : "(none)", i, delivery,
+                    i < actual.size() ? actual[i].c_str() : "(none)");
+        }
+        std::abort();
+    }
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const auto whole = parse_in_chunks(data, size, {});
+
+    std::vector<size_t> cuts;
+    for (size_t i = 1; i < size; ++i) cuts.push_back(i);
+    expect_same(whole, parse_in_chunks(data, size, cuts), "bytewise");
+
+    // FNV-1a of the input seeds the split points, so mutations move them too
+    uint64_t seed = 1469598103934665603ULL;
+    for (size_t i = 0; i < size; ++i) seed = (seed ^ data[i]) * 1099511628211ULL;
+    cuts.clear();
+    for (size_t at = 0; ; ) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        at += 1 + (seed >> 33) % 64;
+        if (at >= size) break;
+        cuts.push_back(at);
+    }
+    expect_same(whole, parse_in_chunks(data, size, cuts), "chunked");
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Driver for compilers without libFuzzer: runs LLVMFuzzerTestOneInput over
+// each file named on the command line (directories are walked one level), or
+// over stdin when none is given, which is how AFL-style harnesses deliver
+// inputs. Flags meant for libFuzzer, such as -runs=0, are ignored.
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+    void run(const std::string& input) {
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    }
+
+    bool run_file(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "Cannot read " << path << std::endl;
+            return false;
+        }
+        run(std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> files;
+    bool named_inputs = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.empty() || arg[0] == '-') continue;
+        named_inputs = true;
+
+        struct stat st;
+        if (stat(arg.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            DIR* dir = opendir(arg.c_str());
+            if (!dir) {
+                std::cerr << "Cannot open " << arg << std::endl;
+                return 1;
+            }
+            while (dirent* entry = readdir(dir)) {
+                const std::string path = arg + "/" + entry->d_name;
+                if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) files.push_back(path);
+            }
+            closedir(dir);
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (!named_inputs) {
+        run(std::string(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>()));
+        return 0;
+    }
+    for (const auto& path : files) {
+        if (!run_file(path)) return 1;
+    }
+    std::cerr << files.size() << " inputs replayed" << std::endl;
+    return 0;
+}
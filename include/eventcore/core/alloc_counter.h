@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+namespace eventcore {
+    namespace alloc {
+
+        // Heap allocation counts. They are only recorded in a build configured with
+        // -DEVENTCORE_ALLOC_COUNTING=ON, which replaces operator new/delete and, on
+        // glibc, malloc/calloc/realloc/free, so every allocation in the process is
+        // counted: per thread, and summed over all threads. Otherwise every count
+        // stays zero and nothing is interposed.
+        struct Stats {
+            uint64_t allocations = 0;
+            uint64_t deallocations = 0;
+            uint64_t bytes = 0;  // Requested by the allocations
+        };
+
+        Stats operator-(const Stats& a, const Stats& b);
+
+        bool counting_enabled();
+        // Counts of the calling thread since it started
+        Stats thread_stats();
+        // Counts of all threads since the process started
+        Stats process_stats();
+
+        // Allocations made since construction, by the calling thread or, with
+        // `process_wide`, by any thread, e.g. a server's workers during a request.
+        class Scope {
+            public:
+                explicit Scope(bool process_wide = false)
+                    : process_wide_(process_wide), start_(process_wide ? process_stats() : thread_stats()) {}
+                Stats delta() const { return (process_wide_ ? process_stats() : thread_stats()) - start_; }
+
+            private:
+                bool process_wide_;
+                Stats start_;
+        };
+
+    } // namespace alloc
+} // namespace eventcore
@@ -0,0 +1,51 @@
+#pragma once
+#include "noncopyable.h"
+#include <cstddef>
+#include <vector>
+
+namespace eventcore {
+
+    enum class HugePageMode {
+        kNone,         // Regular pages
+        kTransparent,  // madvise(MADV_HUGEPAGE) on committed chunks
+        kExplicit      // MAP_HUGETLB chunks, falling back to regular pages if none are free
+    };
+
+    // Fixed-stride object storage in one reserved address range. Memory is
+    // committed a chunk (2 MB, one huge page) at a time the first time a slot
+    // in it is requested, so a large capacity costs address space only.
+    class ChunkedArena : public NonCopyable {
+        public:
+            static constexpr size_t kChunkSize = 2 * 1024 * 1024;
+            static constexpr size_t kSlotAlign = 64;  // Keep slots on separate cache lines
+
+            ChunkedArena(size_t object_size, size_t capacity, HugePageMode mode = HugePageMode::kNone);
+            ~ChunkedArena();
+
+            // Address of slot `index`, committing its chunk if needed; null if the
+            // memory cannot be committed.
+            void* slot(size_t index);
+
+            size_t stride() const { return stride_; }
+            size_t capacity() const { return capacity_; }
+            size_t reserved_bytes() const { return reserved_; }
+            size_t committed_bytes() const { return committed_chunks_ * kChunkSize; }
+            // Chunks mapped on, or advised to use, huge pages
+            size_t huge_chunks() const { return huge_chunks_; }
+
+        private:
+            bool commit(size_t chunk);
+
+            size_t stride_;
+            size_t capacity_;
+            HugePageMode mode_;
+            void* mapping_ = nullptr;
+            size_t mapping_size_ = 0;
+            char* base_ = nullptr;  // First chunk, aligned to kChunkSize
+            size_t reserved_ = 0;
+            std::vector<bool> committed_;
+            size_t committed_chunks_ = 0;
+            size_t huge_chunks_ = 0;
+    };
+
+} // namespace eventcore
@@ -0,0 +1,70 @@
+#pragma once
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace eventcore {
+
+    enum class ErrorCategory : unsigned char {
+        kNone,
+        kSystem,   // code() is an errno value
+        kMessage   // free-form text supplied by the caller
+    };
+
+    // Compact error value: an errno plus a static context string. Nothing is
+    // allocated until to_string() is called, so hot-path failures such as
+    // EAGAIN cost no more than an int copy.
+    class Error {
+        public:
+            Error() = default;
+
+            static Error from_errno(int code, const char* context) {
+                Error error;
+                error.category_ = ErrorCategory::kSystem;
+                error.code_ = code;
+                error.context_ = context;
+                return error;
+            }
+
+            static Error from_message(std::string message) {
+                Error error;
+                error.category_ = ErrorCategory::kMessage;
+                error.message_ = std::move(message);
+                return error;
+            }
+
+            ErrorCategory category() const { return category_; }
+            int code() const { return code_; }
+            const char* context() const { return context_; }
+
+            bool would_block() const {
+                if (category_ != ErrorCategory::kSystem) return false;
+#if EAGAIN != EWOULDBLOCK
+                if (code_ == EWOULDBLOCK) return true;
+#endif
+                return code_ == EAGAIN;
+            }
+
+            std::string to_string() const {
+                switch (category_) {
+                    case ErrorCategory::kSystem: {
+                        std::string text = context_ ? context_ : "system error";
+                        return text + ": " + std::strerror(code_);
+                    }
+                    case ErrorCategory::kMessage:
+                        return message_;
+                    case ErrorCategory::kNone:
+                        break;
+                }
+                return std::string();
+            }
+
+        private:
+            ErrorCategory category_ = ErrorCategory::kNone;
+            int code_ = 0;
+            const char* context_ = nullptr;
+            std::string message_;
+    };
+
+} // namespace eventcore
@@ -0,0 +1,181 @@
+#pragma once
+#include "noncopyable.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace eventcore {
+    namespace metrics {
+
+        // Hot-path metrics are split into shards, one cache line each, and a
+        // thread only ever touches its own shard, so recording is an uncontended
+        // relaxed add. Shards are summed when the registry is scraped.
+        constexpr size_t kShards = 32;
+
+        // Shard of the calling thread, assigned round-robin on first use.
+        size_t this_thread_shard();
+
+        using Labels = std::vector<std::pair<std::string, std::string>>;
+
+        class Counter : public NonCopyable {
+            public:
+                Counter() = default;
+                void inc(uint64_t n = 1) {
+                    cells_[this_thread_shard()].value.fetch_add(n, std::memory_order_relaxed);
+                }
+                uint64_t value() const;
+
+            private:
+                struct Cell {
+                    std::atomic<uint64_t> value{0};
+                    char pad[64 - sizeof(std::atomic<uint64_t>)];
+                };
+                Cell cells_[kShards];
+        };
+
+        class Gauge : public NonCopyable {
+            public:
+                Gauge() = default;
+                void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+                void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+                void sub(int64_t n) { value_.fetch_sub(n, std::memory_order_relaxed); }
+                int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+            private:
+                std::atomic<int64_t> value_{0};
+        };
+
+        // Fixed-bucket histogram over integer observations. `scale` converts the
+        // recorded unit to the exported one, e.g. 1e-9 for nanoseconds recorded
+        // and seconds exported.
+        class Histogram : public NonCopyable {
+            public:
+                struct Snapshot {
+                    std::vector<uint64_t> bounds;  // Inclusive upper bounds
+                    std::vector<uint64_t> counts;  // Per bucket; the last one is +Inf
+                    uint64_t count = 0;
+                    uint64_t sum = 0;
+                };
+
+                explicit Histogram(std::vector<uint64_t> bounds, double scale = 1.0);
+                void observe(uint64_t value);
+                Snapshot snapshot() const;
+                double scale() const { return scale_; }
+
+                // 50 us to 10 s, for latencies recorded in nanoseconds
+                static std::vector<uint64_t> latency_buckets_ns();
+
+            private:
+                std::vector<uint64_t> bounds_;
+                double scale_;
+                size_t stride_;  // Cells per shard: buckets, +Inf and the sum, padded to a cache line
+                std::unique_ptr<std::atomic<uint64_t>[]> cells_;
+        };
+
+        // Log-linear latency histogram in the style of HdrHistogram: values below
+        // 64 are exact and every power of two above is split into 32 buckets, so
+        // any quantile is reported within about 3% across nine decades at a fixed
+        // 8 KB. Recording is two relaxed adds, one to a bucket and one to the sum;
+        // histograms written by different workers are combined by merging
+        // snapshots, without locks.
+        class LatencyHistogram : public NonCopyable {
+            public:
+                static constexpr int kSubBucketBits = 6;
+                static constexpr int kMaxBits = 36;  // Larger values land in the last bucket
+                static constexpr size_t kBuckets =
+                    (size_t(1) << kSubBucketBits) + (kMaxBits - kSubBucketBits) * (size_t(1) << (kSubBucketBits - 1));
+
+                struct Snapshot {
+                    std::vector<uint64_t> counts;
+                    uint64_t count = 0;
+                    uint64_t sum = 0;
+
+                    Snapshot() : counts(kBuckets, 0) {}
+                    void merge(const Snapshot& other);
+                    // Highest value equivalent to the q-th quantile, q in [0, 1]; 0 when empty
+                    uint64_t quantile(double q) const;
+                };
+
+                LatencyHistogram();
+                void record(uint64_t value) {
+                    buckets_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+                    sum_.fetch_add(value, std::memory_order_relaxed);
+                }
+                Snapshot snapshot() const;
+                void merge_into(Snapshot* snapshot) const;
+
+                static size_t bucket_of(uint64_t value);
+                static uint64_t bucket_upper(size_t bucket);
+
+            private:
+                std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+                std::atomic<uint64_t> sum_{0};
+        };
+
+        enum class MetricType { kCounter, kGauge, kHistogram, kSummary };
+
+        // Named metric families with Prometheus-style labels. Registration is
+        // idempotent for the same name and labels and returns the existing metric;
+        // metrics live as long as the registry.
+        class Registry : public NonCopyable {
+            public:
+                using Sampler = std::function<double()>;
+
+                Registry() = default;
+                Counter& counter(const std::string& name, const std::string& help, const Labels& labels = Labels());
+                Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = Labels());
+                Histogram& histogram(const std::string& name, const std::string& help,
+                        std::vector<uint64_t> bounds, double scale = 1.0, const Labels& labels = Labels());
+                // Values read from `sampler` at scrape time, for state another component
+                // already tracks. The sampler must stay callable while the registry lives.
+                void gauge_fn(const std::string& name, const std::string& help, const Labels& labels, Sampler sampler);
+                void counter_fn(const std::string& name, const std::string& help, const Labels& labels, Sampler sampler);
+                // Adds a latency histogram to the series; every histogram added under the
+                // same name and labels, typically one per worker, is merged on scrape and
+                // exported as a summary with p50/p90/p99/p99.9. `scale` converts recorded
+                // values to the exported unit (nanoseconds to seconds by default).
+                LatencyHistogram& latency(const std::string& name, const std::string& help,
+                        const Labels& labels = Labels(), double scale = 1e-9);
+                // Adds histograms recorded under other series to this one, so an
+                // aggregate such as "every route" is derived on scrape instead of
+                // being recorded twice. `parts` must stay alive while the registry lives.
+                void latency_view(const std::string& name, const std::string& help, const Labels& labels,
+                        const std::vector<const LatencyHistogram*>& parts, double scale = 1e-9);
+
+                // Prometheus text exposition format, version 0.0.4
+                std::string render() const;
+
+            private:
+                struct Series {
+                    std::string labels;  // Rendered, without braces
+                    std::unique_ptr<Counter> counter;
+                    std::unique_ptr<Gauge> gauge;
+                    std::unique_ptr<Histogram> histogram;
+                    std::vector<std::unique_ptr<LatencyHistogram>> latencies;
+                    std::vector<const LatencyHistogram*> latency_views;
+                    double latency_scale = 1.0;
+                    Sampler sampler;
+                };
+                struct Family {
+                    std::string name;
+                    std::string help;
+                    MetricType type;
+                    std::vector<Series> series;
+                };
+
+                Series& series(const std::string& name, const std::string& help, MetricType type,
+                        const Labels& labels, bool* created);
+
+                mutable std::mutex mutex_;
+                std::vector<Family> families_;  // Rendered in registration order
+                std::unordered_map<std::string, size_t> index_;
+        };
+
+    } // namespace metrics
+} // namespace eventcore
@@ -0,0 +1,50 @@
+#pragma once
+#include "noncopyable.h"
+#include <cstddef>
+
+namespace eventcore {
+
+    // Bump-pointer allocator for short-lived data that dies all at once, such
+    // as the strings of one HTTP request. Nothing is freed individually;
+    // reset() drops every allocation and keeps the largest block for reuse,
+    // so a steady workload stops touching the heap after warm-up.
+    class MonotonicArena : public NonCopyable {
+        public:
+            static constexpr size_t kDefaultBlockSize = 1024;
+            static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+            // No memory is taken until the first allocation.
+            explicit MonotonicArena(size_t block_size = kDefaultBlockSize);
+            ~MonotonicArena();
+            MonotonicArena(MonotonicArena&& other) noexcept;
+            MonotonicArena& operator=(MonotonicArena&& other) noexcept;
+
+            void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+            // Copies `size` bytes in; the result stays valid until reset().
+            char* copy(const char* data, size_t size);
+            void reset();
+
+            size_t used_bytes() const { return used_; }
+            size_t reserved_bytes() const { return reserved_; }
+            size_t num_blocks() const { return blocks_; }
+
+        private:
+            struct Block {
+                Block* next;
+                size_t size;
+                char* data() { return reinterpret_cast<char*>(this + 1); }
+            };
+
+            void grow(size_t min_size, size_t align);
+            void release_all();
+
+            size_t block_size_;
+            Block* head_ = nullptr;  // Newest, and largest, block
+            char* cursor_ = nullptr;
+            char* limit_ = nullptr;
+            size_t used_ = 0;
+            size_t reserved_ = 0;
+            size_t blocks_ = 0;
+    };
+
+} // namespace eventcore
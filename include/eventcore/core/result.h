@@ -1,39 +1,78 @@
 #pragma once
+#include "error.h"
+#include <new>
 #include <string>
-#include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace eventcore {
 
+    // Value-or-error without heap allocation: T lives in inline storage and
+    // failures carry a compact Error that is only turned into text on demand.
     template<typename T>
         class Result {
             public:
                 static Result<T> Ok(T value) {
                     Result<T> result;
-                    result.value_ = std::make_unique<T>(std::move(value));
+                    new (&result.storage_) T(std::move(value));
                     result.ok_ = true;
                     return result;
                 }
 
-                static Result<T> Err(std::string error) {
+                static Result<T> Err(Error error) {
                     Result<T> result;
                     result.error_ = std::move(error);
-                    result.ok_ = false;
                     return result;
                 }
 
+                static Result<T> Err(std::string error) {
+                    return Err(Error::from_message(std::move(error)));
+                }
+
+                Result(const Result& other) : error_(other.error_), ok_(other.ok_) {
+                    if (ok_) new (&storage_) T(other.value());
+                }
+
+                Result(Result&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+                    : error_(std::move(other.error_)), ok_(other.ok_) {
+                        if (ok_) new (&storage_) T(std::move(other.value()));
+                    }
+
+                Result& operator=(Result other) {
+                    reset();
+                    error_ = std::move(other.error_);
+                    if (other.ok_) {
+                        new (&storage_) T(std::move(other.value()));
+                        ok_ = true;
+                    }
+                    return *this;
+                }
+
+                ~Result() { reset(); }
+
                 bool is_ok() const { return ok_; }
                 bool is_err() const { return !ok_; }
-                const T& value() const { return *value_; }
-                T& value() { return *value_; }
-                const std::string& error() const { return error_; }
+                const T& value() const { return *reinterpret_cast<const T*>(&storage_); }
+                T& value() { return *reinterpret_cast<T*>(&storage_); }
+                const Error& error_code() const { return error_; }
+                bool would_block() const { return error_.would_block(); }
+                std::string error() const { return error_.to_string(); }
                 T value_or(T default_value) const {
-                    return ok_ ? *value_ : std::move(default_value);
+                    return ok_ ? value() : std::move(default_value);
                 }
 
             private:
-                std::unique_ptr<T> value_;
-                std::string error_;
+                Result() = default;
+
+                void reset() {
+                    if (ok_) {
+                        value().~T();
+                        ok_ = false;
+                    }
+                }
+
+                typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+                Error error_;
                 bool ok_ = false;
         };
 
@@ -47,19 +86,24 @@ namespace eventcore {
                     return result;
                 }
 
-                static Result<void> Err(std::string error) {
+                static Result<void> Err(Error error) {
                     Result<void> result;
                     result.error_ = std::move(error);
-                    result.ok_ = false;
                     return result;
                 }
 
+                static Result<void> Err(std::string error) {
+                    return Err(Error::from_message(std::move(error)));
+                }
+
                 bool is_ok() const { return ok_; }
                 bool is_err() const { return !ok_; }
-                const std::string& error() const { return error_; }
+                const Error& error_code() const { return error_; }
+                bool would_block() const { return error_.would_block(); }
+                std::string error() const { return error_.to_string(); }
 
             private:
-                std::string error_;
+                Error error_;
                 bool ok_ = false;
         };
 
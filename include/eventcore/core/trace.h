@@ -0,0 +1,92 @@
+#pragma once
+#include "noncopyable.h"
+#include "result.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace eventcore {
+    namespace trace {
+
+        // Points in a connection's life recorded by the flight recorder.
+        enum class EventType : uint8_t {
+            kAccept,         // arg: fd
+            kFirstByte,      // First byte of a request seen; arg: bytes buffered
+            kParseDone,      // arg: body bytes
+            kHandlerStart,
+            kHandlerEnd,     // arg: response status
+            kWriteComplete,  // Write buffer drained; arg: bytes in the last write
+            kClose,
+        };
+
+        const char* event_name(EventType type);
+
+        // Fixed-size record, also the on-disk format of a dump.
+        struct Event {
+            uint64_t timestamp_ns;  // steady_clock
+            uint64_t connection;    // Unique per worker
+            uint32_t arg;
+            uint16_t worker;
+            EventType type;
+            uint8_t reserved;
+        };
+        static_assert(sizeof(Event) == 24, "trace::Event is part of the dump format");
+
+        uint64_t now_ns();
+
+        // Sizes and counts are stored in Event::arg saturated to 32 bits
+        inline uint32_t saturate(uint64_t value) {
+            return value > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(value);
+        }
+
+        // Ring buffer of the most recent events of one worker. Recording is a
+        // few relaxed stores into a slot claimed with one fetch_add, so it is
+        // cheap enough to leave on; the loop thread and the pool threads all
+        // write into it. Each slot carries a sequence number, written last, so
+        // a snapshot taken while writers run skips slots caught mid-update.
+        class FlightRecorder : public NonCopyable {
+            public:
+                // `capacity` is rounded up to a power of two
+                explicit FlightRecorder(uint16_t worker, size_t capacity = 16384);
+
+                void record(EventType type, uint64_t connection, uint32_t arg = 0) {
+                    record_at(now_ns(), type, connection, arg);
+                }
+                void record_at(uint64_t timestamp_ns, EventType type, uint64_t connection, uint32_t arg);
+
+                // Events still in the ring, oldest first
+                std::vector<Event> snapshot() const;
+                size_t capacity() const { return mask_ + 1; }
+                uint64_t recorded() const { return next_.load(std::memory_order_relaxed); }
+
+            private:
+                struct Slot {
+                    // 0 while empty, odd while being written, 2 * (index + 1) once complete
+                    std::atomic<uint64_t> sequence{0};
+                    std::atomic<uint64_t> timestamp_ns{0};
+                    std::atomic<uint64_t> connection{0};
+                    std::atomic<uint64_t> packed{0};  // arg | type << 32
+                };
+
+                uint16_t worker_;
+                size_t mask_;
+                std::unique_ptr<Slot[]> slots_;
+                std::atomic<uint64_t> next_{0};
+        };
+
+        // Dump format: a 24-byte header ("ECTRACE1", version, event size,
+        // event count) followed by the events in host byte order.
+        std::string serialize(const std::vector<Event>& events);
+        Result<std::vector<Event>> deserialize(const std::string& data);
+        Result<void> write_file(const std::string& path, const std::vector<Event>& events);
+        Result<std::vector<Event>> read_file(const std::string& path);
+
+        // Chrome trace-event JSON, loadable in chrome://tracing or Perfetto. Each
+        // worker is a process and each connection a thread; handler start and end
+        // become a slice, everything else an instant event.
+        std::string to_chrome_json(const std::vector<Event>& events);
+
+    } // namespace trace
+} // namespace eventcore
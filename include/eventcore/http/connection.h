@@ -1,5 +1,7 @@
 #pragma once
 #include "../core/noncopyable.h"
+#include "../core/metrics.h"
+#include "../core/trace.h"
 #include "../net/socket.h"
 #include "../net/buffer.h"
 #include "parser.h"
@@ -8,10 +10,21 @@
 #include <memory>
 #include <functional>
 #include <chrono>
+#include <atomic>
 
 namespace eventcore {
     namespace http {
 
+        // Where a connection records its traffic; owned by a metrics::Registry.
+        struct ConnectionMetrics {
+            metrics::Counter* requests = nullptr;
+            metrics::Counter* rejected_requests = nullptr;
+            metrics::Counter* bytes_received = nullptr;
+            metrics::Counter* bytes_sent = nullptr;
+            metrics::LatencyHistogram* parse_latency = nullptr;  // Per request, across reads
+            metrics::LatencyHistogram* write_latency = nullptr;  // Per flush
+        };
+
         class Connection : public NonCopyable, public std::enable_shared_from_this<Connection> {
             public:
                 using ConnectionPtr = std::shared_ptr<Connection>;
@@ -21,6 +34,18 @@ namespace eventcore {
                 Connection(net::Socket socket, RequestHandler handler);
                 ~Connection();
                 void reset(int fd);
+                // Draws buffer slabs from `pool`; drops any buffered data.
+                void set_buffer_pool(net::SlabPool* pool);
+                // Requests beyond these are answered with 400/413/414/431 and closed
+                void set_parser_limits(const ParserLimits& limits);
+                // All fields must be set; null disables recording.
+                void set_metrics(const ConnectionMetrics* metrics) { metrics_ = metrics; }
+                // Records the connection's life into `recorder` as connection `id`;
+                // null disables tracing.
+                void set_trace(trace::FlightRecorder* recorder, uint64_t id) {
+                    trace_ = recorder;
+                    trace_id_ = id;
+                }
                 void update_activity();
                 bool is_idle(std::chrono::seconds timeout) const;
                 void start();
@@ -30,25 +55,69 @@ namespace eventcore {
                 void shutdown();
                 void force_close();
                 void set_close_callback(CloseCallback cb) { close_callback_ = cb; }
+                // With deferred close, force_close() only marks the connection closed
+                // and the owner calls close_socket() once it has unregistered the fd.
+                void set_deferred_close(bool deferred) { deferred_close_ = deferred; }
+                void close_socket() { socket_.close(); }
                 bool is_connected() const { return state_ == kConnected; }
+                // Connected, or closing once queued output has been written
+                bool is_open() const {
+                    State state = state_;
+                    return state == kConnected || state == kDisconnecting || state == kLingering;
+                }
+                // Output is queued that the socket has not accepted yet; the owner
+                // should wait for writability and call handle_write().
+                bool wants_write() const {
+                    State state = state_;
+                    return (state == kConnected || state == kDisconnecting || state == kLingering) &&
+                        write_buffer_.readable_bytes() > 0;
+                }
+                size_t pending_output() const { return write_buffer_.readable_bytes(); }
+                // Reading and parsing pause while this much output is unsent, so a
+                // client that pipelines without reading cannot grow the write buffer
+                // unbounded. handle_read() resumes both once writes have drained.
+                static constexpr size_t kOutputHighWaterMark = 1024 * 1024;
+                bool wants_read() const {
+                    State state = state_;
+                    return (state == kConnected && !output_backlogged()) || state == kLingering;
+                }
+                // After rejecting a request, input is read and discarded for up to this
+                // long so that closing with unread data does not send a reset that
+                // could reach the client before the error response.
+                static constexpr std::chrono::seconds kLingerTime{2};
                 int fd() const { return socket_.fd(); }
 
             private:
-                enum State { kConnecting, kConnected, kDisconnecting, kDisconnected };
+                // kLingering: an error response is queued; input is discarded until
+                // the peer closes or kLingerTime passes.
+                enum State { kConnecting, kConnected, kDisconnecting, kLingering, kDisconnected };
                 void handle_error();
                 void handle_close();
                 void process_request();
-                void send_response(const Response& response);
+                // Serializes behind earlier responses without flushing
+                void queue_response(Response& response);
+                void reject_request(int status);
+                void discard_input();
+                bool output_backlogged() const { return write_buffer_.readable_bytes() >= kOutputHighWaterMark; }
 
-                std::chrono::steady_clock::time_point last_activity_;
+                // Read by the owning worker's idle scan while a pool thread updates it
+                std::atomic<std::chrono::steady_clock::rep> last_activity_;
+                std::atomic<std::chrono::steady_clock::rep> linger_deadline_{0};
                 net::Socket socket_;
-                State state_;
+                std::atomic<State> state_;
+                bool deferred_close_ = false;
                 net::Buffer read_buffer_;
                 net::Buffer write_buffer_;
                 Parser parser_;
                 Request request_;
                 RequestHandler request_handler_;
                 CloseCallback close_callback_;
+                const ConnectionMetrics* metrics_ = nullptr;
+                uint64_t parse_ns_ = 0;  // Parse time of the request in progress
+                trace::FlightRecorder* trace_ = nullptr;
+                uint64_t trace_id_ = 0;
+                bool request_started_ = false;  // First byte of the current request traced
+                bool parse_paused_ = false;  // Buffered input left unparsed at the high-water mark
         };
 
         using ConnectionPtr = std::shared_ptr<Connection>;
@@ -0,0 +1,86 @@
+#pragma once
+#include "../core/monotonic_arena.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace eventcore {
+    namespace http {
+
+        // Headers the server or typical handlers look at, recognised once when a
+        // field is stored so later lookups index a slot instead of comparing names.
+        enum class HeaderId : uint8_t {
+            kHost, kConnection, kContentLength, kContentType, kTransferEncoding,
+            kAcceptEncoding, kAccept, kUserAgent, kCookie, kAuthorization,
+            kCacheControl, kContentEncoding, kDate, kServer, kUpgrade, kExpect,
+            kKeepAlive, kIfNoneMatch, kLocation, kSetCookie, kAcceptLanguage,
+            kReferer, kOrigin, kRange, kLastModified, kETag,
+            kUnknown
+        };
+
+        constexpr size_t kNumKnownHeaders = static_cast<size_t>(HeaderId::kUnknown);
+
+        // Case-insensitive; kUnknown for anything outside the table above.
+        HeaderId lookup_header(const char* name, size_t size);
+        const char* header_name(HeaderId id);
+        bool equals_ignore_case(const char* a, size_t a_size, const char* b, size_t b_size);
+
+        // Header fields in insertion order. Names and values are copied into
+        // the list's own arena, so adding a header costs a bump-pointer copy
+        // rather than map nodes and string allocations, and clear() releases
+        // them all at once. Names match case-insensitively; known headers are
+        // found through a fixed slot per HeaderId, the rest by a linear scan.
+        class HeaderList {
+            public:
+                struct Field {
+                    const char* name;
+                    char* value;
+                    uint32_t name_size;
+                    uint32_t value_size;
+                    uint32_t value_capacity;
+                    HeaderId id;
+
+                    std::string name_string() const { return std::string(name, name_size); }
+                    std::string value_string() const { return std::string(value, value_size); }
+                    bool value_equals(const char* s, size_t size) const {
+                        return equals_ignore_case(value, value_size, s, size);
+                    }
+                };
+                using const_iterator = std::vector<Field>::const_iterator;
+
+                HeaderList();
+                HeaderList(const HeaderList& other);
+                HeaderList& operator=(const HeaderList& other);
+                HeaderList(HeaderList&& other) noexcept;
+                HeaderList& operator=(HeaderList&& other) noexcept;
+
+                const Field* find(HeaderId id) const;
+                const Field* find(const char* name, size_t size) const;
+                const Field* find(const std::string& name) const { return find(name.data(), name.size()); }
+                // Replaces the value of an existing field with the same name and
+                // returns the field's HeaderId.
+                HeaderId set(const char* name, size_t name_size, const char* value, size_t value_size);
+                HeaderId set(const std::string& name, const std::string& value) {
+                    return set(name.data(), name.size(), value.data(), value.size());
+                }
+                void clear();
+
+                size_t size() const { return fields_.size(); }
+                bool empty() const { return fields_.empty(); }
+                const_iterator begin() const { return fields_.begin(); }
+                const_iterator end() const { return fields_.end(); }
+                const MonotonicArena& arena() const { return arena_; }
+
+            private:
+                static constexpr uint16_t kNoField = 0xffff;
+
+                Field* find_field(HeaderId id, const char* name, size_t size);
+                void append_copy(const HeaderList& other);
+
+                MonotonicArena arena_{512};
+                std::vector<Field> fields_;
+                uint16_t known_[kNumKnownHeaders];  // Index into fields_, or kNoField
+        };
+
+    } // namespace http
+} // namespace eventcore
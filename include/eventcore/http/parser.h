@@ -5,22 +5,44 @@
 namespace eventcore {
     namespace http {
 
+        // Bounds on a single request, checked as bytes arrive so that an oversized
+        // request is rejected before the connection buffers it.
+        struct ParserLimits {
+            size_t max_request_line = 8 * 1024;   // 414 URI Too Long
+            size_t max_header_count = 100;        // 431 Request Header Fields Too Large
+            size_t max_header_bytes = 32 * 1024;  // 431, counting the whole header block
+            size_t max_body_size = 1024 * 1024;   // 413 Payload Too Large
+        };
+
         class Parser {
             public:
-                enum State { kExpectRequestLine, kExpectHeaders, kExpectBody, kComplete };
-                Parser();
+                enum State { kExpectRequestLine, kExpectHeaders, kExpectBody, kComplete, kError };
+                explicit Parser(const ParserLimits& limits = ParserLimits());
+                // False until a whole request is parsed, or after a protocol error.
                 bool parse_request(net::Buffer* buffer, Request* request);
                 bool is_complete() const { return state_ == kComplete; }
+                bool has_error() const { return state_ == kError; }
+                // Status the request must be rejected with once has_error() is set
+                int error_status() const { return error_status_; }
+                void set_limits(const ParserLimits& limits) { limits_ = limits; }
+                const ParserLimits& limits() const { return limits_; }
                 void reset();
 
             private:
                 bool parse_request_line(const char* begin, const char* end);
                 bool parse_headers(net::Buffer* buffer);
                 bool parse_body(net::Buffer* buffer);
+                bool parse_content_length(const char* begin, const char* end);
+                bool fail(int status);
 
                 State state_;
                 Request* request_;
                 size_t content_length_;
+                bool has_content_length_ = false;
+                ParserLimits limits_;
+                size_t header_bytes_ = 0;
+                size_t header_count_ = 0;
+                int error_status_ = 0;
         };
 
     } // namespace http
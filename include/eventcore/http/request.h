@@ -1,6 +1,6 @@
 #pragma once
+#include "headers.h"
 #include <string>
-#include <unordered_map>
 
 namespace eventcore {
     namespace http {
@@ -14,17 +14,27 @@ namespace eventcore {
                 const std::string& path() const { return path_; }
                 const std::string& query() const { return query_; }
                 Version version() const { return version_; }
-                const std::unordered_map<std::string, std::string>& headers() const { return headers_; }
+                const HeaderList& headers() const { return headers_; }
                 const std::string& body() const { return body_; }
 
+                // Header names match case-insensitively
                 std::string get_header(const std::string& name) const;
                 bool has_header(const std::string& name) const;
+                const HeaderList::Field* header(HeaderId id) const { return headers_.find(id); }
                 void set_method(Method method) { method_ = method; }
                 void set_path(const std::string& path) { path_ = path; }
+                void set_path(const char* data, size_t size) { path_.assign(data, size); }
                 void set_query(const std::string& query) { query_ = query; }
+                void set_query(const char* data, size_t size) { query_.assign(data, size); }
                 void set_version(Version version) { version_ = version; }
                 void set_header(const std::string& name, const std::string& value);
+                HeaderId set_header(const char* name, size_t name_size, const char* value, size_t value_size) {
+                    return headers_.set(name, name_size, value, value_size);
+                }
                 void set_body(const std::string& body) { body_ = body; }
+                // Clears the request for reuse. String capacity is kept and the
+                // header arena is reset in bulk, so a connection that reuses one
+                // Request stops allocating once warmed up.
                 void reset();
 
                 static Method string_to_method(const std::string& str);
@@ -36,7 +46,7 @@ namespace eventcore {
                 std::string path_;
                 std::string query_;
                 Version version_ = Version::UNKNOWN;
-                std::unordered_map<std::string, std::string> headers_;
+                HeaderList headers_;
                 std::string body_;
         };
 
@@ -1,6 +1,7 @@
 #pragma once
+#include "headers.h"
+#include "../net/buffer.h"
 #include <string>
-#include <unordered_map>
 
 namespace eventcore {
     namespace http {
@@ -10,7 +11,7 @@ namespace eventcore {
                 Response();
                 int status_code() const { return status_code_; }
                 const std::string& status_message() const { return status_message_; }
-                const std::unordered_map<std::string, std::string>& headers() const { return headers_; }
+                const HeaderList& headers() const { return headers_; }
                 const std::string& body() const { return body_; }
 
                 void set_status(int code, const std::string& message = "");
@@ -20,6 +21,8 @@ namespace eventcore {
                 void set_content_type(const std::string& type);
                 void set_keep_alive(bool keep_alive);
                 std::string to_string() const;
+                // Appends the wire form to `out` without building an intermediate string.
+                void serialize(net::Buffer* out) const;
 
                 static Response make_404();
                 static Response make_500();
@@ -29,10 +32,11 @@ namespace eventcore {
             private:
                 int status_code_;
                 std::string status_message_;
-                std::unordered_map<std::string, std::string> headers_;
+                HeaderList headers_;
                 std::string body_;
                 bool keep_alive_ = true;
                 std::string default_status_message(int code) const;
+                template <typename Output> void write_to(Output& out) const;
         };
 
     } // namespace http
@@ -24,6 +24,15 @@ namespace eventcore {
                 void set_not_found_handler(Handler handler);
                 void set_error_handler(std::function<Response(const std::exception&)> handler);
                 Response route(const Request& request) const;
+                // Also reports the matched route: its index in registration order, or
+                // kNoRoute when none matched.
+                Response route(const Request& request, size_t* route_id) const;
+
+                static constexpr size_t kNoRoute = static_cast<size_t>(-1);
+                size_t num_routes() const { return patterns_.size(); }
+                // Whether a route was registered for exactly this method and pattern
+                bool has_route(Method method, const std::string& pattern) const;
+                const std::string& route_pattern(size_t id) const { return patterns_[id]; }
 
             private:
                 struct Route {
@@ -31,10 +40,12 @@ namespace eventcore {
                     std::regex regex;
                     Handler handler;
                     bool is_regex;
+                    size_t id;
                 };
 
                 std::unordered_map<Method, std::vector<Route>> routes_;
                 std::vector<std::pair<std::string, Middleware>> middlewares_;
+                std::vector<std::string> patterns_;  // Indexed by route id
                 Handler not_found_handler_;
                 std::function<Response(const std::exception&)> error_handler_;
 
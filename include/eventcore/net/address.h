@@ -1,26 +1,48 @@
 #pragma once
+#include "../core/result.h"
 #include <string>
 #include <cstdint>
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 namespace eventcore {
     namespace net {
 
+        // A socket address of any supported family: IPv4, IPv6 or a unix domain
+        // stream path. Paths starting with '@' name Linux abstract sockets.
         class Address {
             public:
-                Address() = default;
+                Address();
+                // `ip` may be an IPv4 or IPv6 literal; the family is picked from it.
                 Address(const std::string& ip, uint16_t port);
                 explicit Address(const struct sockaddr_in& addr);
+                explicit Address(const struct sockaddr_in6& addr);
+                Address(const struct sockaddr* addr, socklen_t len);
+
+                // A path, or an abstract name written "@name". Fails when the path
+                // does not fit sun_path, NUL terminator included, rather than
+                // silently binding a truncated one.
+                static Result<Address> unix_path(const std::string& path);
+                // Accepts "host:port", "[v6-host]:port" and "unix:/path".
+                static Result<Address> parse(const std::string& spec);
+
+                int family() const { return addr_.ss_family; }
+                bool is_ipv4() const { return family() == AF_INET; }
+                bool is_ipv6() const { return family() == AF_INET6; }
+                bool is_unix() const { return family() == AF_UNIX; }
 
                 std::string ip() const;
                 uint16_t port() const;
+                std::string path() const;
                 std::string to_string() const;
                 const struct sockaddr* sockaddr() const;
-                socklen_t socklen() const;
+                socklen_t socklen() const { return len_; }
                 static Address from_sockaddr(const struct sockaddr_in& addr);
 
             private:
-                struct sockaddr_in addr_;
+                struct sockaddr_storage addr_;
+                socklen_t len_;
         };
 
     } // namespace net
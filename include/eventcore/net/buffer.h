@@ -1,49 +1,84 @@
 #pragma once
-#include <vector>
+#include "../core/noncopyable.h"
+#include "slab_pool.h"
+#include <deque>
 #include <string>
 #include <cstring>
-#include <algorithm>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 namespace eventcore {
     namespace net {
 
-        class Buffer {
+        // Byte queue built from a chain of pooled slabs. Appends fill the tail
+        // slab and then chain new ones, so growth never reallocates or moves
+        // existing data. Offsets returned by the find helpers are relative to
+        // the first readable byte.
+        class Buffer : public NonCopyable {
             public:
-                static constexpr size_t kInitialSize = 1024;
-                static constexpr size_t kPrependSize = 8;
+                static constexpr size_t kNpos = static_cast<size_t>(-1);
+                static constexpr size_t kMaxIovecs = 16;
                 static const char kCRLF[];
 
-                explicit Buffer(size_t initial_size = kInitialSize);
-                size_t readable_bytes() const { return write_index_ - read_index_; }
-                size_t writable_bytes() const { return buffer_.size() - write_index_; }
-                size_t prependable_bytes() const { return read_index_; }
-                const char* peek() const { return begin() + read_index_; }
+                explicit Buffer(SlabPool* pool = nullptr);
+                ~Buffer();
+                Buffer(Buffer&& other) noexcept;
+                Buffer& operator=(Buffer&& other) noexcept;
+
+                // Releases all slabs and draws future ones from `pool`.
+                void set_pool(SlabPool* pool);
+                SlabPool* pool() const { return pool_; }
+
+                size_t readable_bytes() const { return readable_; }
+                bool empty() const { return readable_ == 0; }
+                size_t num_slabs() const { return segments_.size(); }
+                size_t capacity() const;
+
+                // First contiguous run of readable bytes.
+                const char* peek() const;
+                size_t contiguous_bytes() const;
+                // Makes the first `len` readable bytes contiguous and returns them,
+                // copying only when they currently span slabs.
+                const char* contiguous(size_t len);
+
+                size_t find_crlf(size_t from = 0) const;
+                size_t find_eol(size_t from = 0) const;
+                void copy_out(char* dest, size_t len) const;
 
                 void retrieve(size_t len);
                 void retrieve_all();
                 std::string retrieve_as_string(size_t len);
                 std::string retrieve_all_as_string();
+                // Detaches the first `len` bytes into a new buffer sharing the slabs.
+                Buffer slice(size_t len);
+                // Releases every slab, including the retained tail.
+                void clear();
+                // Returns the retained tail slab to the pool if nothing is buffered.
+                void shrink();
+
                 void append(const char* data, size_t len);
                 void append(const std::string& str);
                 void append(const void* data, size_t len);
-                void ensure_writable(size_t len);
-                char* begin_write() { return begin() + write_index_; }
-                const char* begin_write() const { return begin() + write_index_; }
-                void has_written(size_t len) { write_index_ += len; }
+                void append(Buffer&& other);
+
+                // Fills `iov` with up to `max` readable runs; returns the count used.
+                size_t peek_iovec(struct iovec* iov, size_t max) const;
                 ssize_t read_from_fd(int fd);
-                const char* find_crlf() const;
-                const char* find_crlf(const char* start) const;
-                const char* find_eol() const;
-                const char* find_eol(const char* start) const;
+                ssize_t write_to_fd(int fd);
 
             private:
-                char* begin() { return &*buffer_.begin(); }
-                const char* begin() const { return &*buffer_.begin(); }
-                void make_space(size_t len);
+                struct Segment {
+                    Slab* slab;
+                    size_t begin;
+                    size_t end;
+                };
+
+                bool tail_writable() const;
+                void push_slab(Slab* slab, size_t used);
 
-                std::vector<char> buffer_;
-                size_t read_index_;
-                size_t write_index_;
+                SlabPool* pool_;
+                std::deque<Segment> segments_;
+                size_t readable_ = 0;
         };
 
     } // namespace net
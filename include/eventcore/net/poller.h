@@ -4,6 +4,9 @@
 #include <unordered_map>
 #include <functional>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
 #ifdef __linux__
 #include <sys/epoll.h>
@@ -12,6 +15,13 @@
 namespace eventcore {
     namespace net {
 
+        // A saturated poll returned as many events as its array holds, so more
+        // may have been ready; the epoll array doubles each time this happens.
+        struct PollerStats {
+            uint64_t saturated_polls = 0;
+            size_t event_capacity = 0;  // 0 when the backend has no fixed array
+        };
+
         class Poller : public NonCopyable {
             public:
                 enum Events { kNone = 0, kReadable = 1, kWritable = 2, kError = 4 };
@@ -22,7 +32,15 @@ namespace eventcore {
                 virtual bool modify(int fd, int events) = 0;
                 virtual bool remove(int fd) = 0;
                 virtual int poll(int timeout_ms) = 0;
+                // Safe to call from any thread
+                virtual PollerStats stats() const { return PollerStats(); }
+                // When the last poll that returned events woke up; callbacks run
+                // during poll() can use it as the readiness time of their event.
+                std::chrono::steady_clock::time_point ready_time() const { return ready_time_; }
                 static std::unique_ptr<Poller> create();
+
+            protected:
+                std::chrono::steady_clock::time_point ready_time_;
         };
 
 #ifdef __linux__
@@ -34,10 +52,13 @@ namespace eventcore {
                 bool modify(int fd, int events) override;
                 bool remove(int fd) override;
                 int poll(int timeout_ms) override;
+                PollerStats stats() const override;
 
             private:
                 int epfd_;
                 std::vector<struct epoll_event> events_;
+                std::atomic<uint64_t> saturated_polls_{0};
+                std::atomic<size_t> event_capacity_{0};
                 std::unordered_map<int, EventCallback> callbacks_;
         };
 #endif
@@ -0,0 +1,65 @@
+#pragma once
+#include "../core/noncopyable.h"
+#include "slab_pool.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <sys/uio.h>
+
+namespace eventcore {
+    namespace net {
+
+        struct ReadStats {
+            uint64_t reads = 0;            // readv calls that returned data
+            uint64_t overflow_reads = 0;   // reads that spilled past the buffer's tail slab
+            uint64_t adopted_slabs = 0;    // scratch slabs handed to buffers
+            uint64_t exhausted_reads = 0;  // reads that filled the whole receive area
+        };
+
+        // Per-thread receive area made of spare slabs. Buffer::read_from_fd
+        // reads into the buffer's tail plus these slabs and then adopts the ones
+        // that received data, so overflow never needs a copy. Replacement slabs
+        // are drawn lazily before the next read.
+        class ReadScratch : public NonCopyable {
+            public:
+                static constexpr size_t kTargetBytes = 64 * 1024;
+
+                // The calling thread's scratch, bound to `pool`.
+                static ReadScratch& local(SlabPool* pool);
+
+                // Tops up the spare slabs and describes them in `iov`; returns the count.
+                size_t prepare(struct iovec* iov, size_t max);
+                // Spare slab `i` as laid out by the last prepare().
+                Slab* spare(size_t i) const { return spares_[i]; }
+                // Drops the first `count` spares, which now belong to a buffer.
+                void adopt(size_t count, bool exhausted);
+                void record_read();
+
+                // Totals over all threads, including ones that have exited.
+                static ReadStats stats();
+                // Number of spares all threads currently hold from `pool`.
+                static size_t held(const SlabPool* pool);
+                // Returns every thread's spares taken from `pool`; called as it is destroyed.
+                static void forget_pool(SlabPool* pool);
+
+                ~ReadScratch();
+
+            private:
+                ReadScratch();
+                void release_spares();
+                static void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+                    // Only the owning thread writes, so no read-modify-write is needed
+                    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+                }
+
+                SlabPool* pool_ = nullptr;
+                std::vector<Slab*> spares_;             // Owner thread only
+                std::atomic<size_t> spare_count_{0};    // spares_.size(), for held()
+                std::atomic<uint64_t> reads_{0};
+                std::atomic<uint64_t> overflow_reads_{0};
+                std::atomic<uint64_t> adopted_slabs_{0};
+                std::atomic<uint64_t> exhausted_reads_{0};
+        };
+
+    } // namespace net
+} // namespace eventcore
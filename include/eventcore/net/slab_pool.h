@@ -0,0 +1,92 @@
+#pragma once
+#include "../core/noncopyable.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace eventcore {
+    namespace net {
+
+        class SlabPool;
+
+        // Fixed-capacity, reference-counted chunk of buffer memory. The payload
+        // follows the header in the same allocation.
+        struct Slab {
+            SlabPool* pool;  // Owner to return to
+            std::atomic<uint32_t> refs;
+            uint32_t capacity;
+
+            char* data() { return reinterpret_cast<char*>(this + 1); }
+            const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+        };
+
+        struct SlabPoolStats {
+            static constexpr size_t kNumClasses = 3;
+            struct SizeClass {
+                size_t slab_size = 0;
+                size_t in_use = 0;
+                size_t cached = 0;
+            };
+
+            SizeClass classes[kNumClasses];  // in_use excludes scratch slabs
+            size_t scratch = 0;  // Base-size spares parked in threads' ReadScratch
+            size_t oversize_in_use = 0;
+            size_t oversize_bytes = 0;
+
+            size_t bytes_in_use() const;
+            size_t bytes_cached() const;
+            SlabPoolStats& operator+=(const SlabPoolStats& other);
+        };
+
+        // Size-classed free lists of slabs shared by the buffers of one worker.
+        // Classes grow by 4x from slab_size(); larger requests get an exact,
+        // uncached allocation. Slabs may be released from any thread.
+        class SlabPool : public NonCopyable {
+            public:
+                static constexpr size_t kDefaultSlabSize = 4096;
+                static constexpr size_t kDefaultMaxCached = 1024;
+                static constexpr size_t kNumClasses = SlabPoolStats::kNumClasses;
+
+                // Each class caches at most `max_cached` base-size slabs' worth of bytes.
+                explicit SlabPool(size_t slab_size = kDefaultSlabSize,
+                        size_t max_cached = kDefaultMaxCached);
+                ~SlabPool();
+
+                // Returns a slab holding at least `min_capacity` bytes with one reference.
+                Slab* allocate(size_t min_capacity = 0);
+
+                static void retain(Slab* slab) { slab->refs.fetch_add(1, std::memory_order_relaxed); }
+                static void release(Slab* slab);
+
+                size_t slab_size() const { return class_size_[0]; }
+                size_t max_slab_size() const { return class_size_[kNumClasses - 1]; }
+                size_t cached() const;
+                size_t in_use() const;
+                SlabPoolStats stats() const;
+                // Frees every cached slab back to the allocator.
+                void trim();
+
+                // Process-wide pool for buffers not bound to a worker.
+                static SlabPool& default_pool();
+
+            private:
+                struct FreeList {
+                    std::vector<Slab*> slabs;
+                    std::atomic<size_t> in_use{0};
+                };
+
+                size_t class_of(size_t capacity) const;
+                void recycle(Slab* slab);
+
+                size_t class_size_[kNumClasses];
+                const size_t max_cached_;
+                mutable std::mutex mutex_;
+                FreeList classes_[kNumClasses];
+                std::atomic<size_t> oversize_in_use_{0};
+                std::atomic<size_t> oversize_bytes_{0};
+        };
+
+    } // namespace net
+} // namespace eventcore
@@ -2,6 +2,8 @@
 #include "../core/noncopyable.h"
 #include "../core/result.h"
 #include "address.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <string>
 #include <cstdint>
 
@@ -19,20 +21,35 @@ namespace eventcore {
                 Result<void> bind(const Address& addr);
                 Result<void> listen(int backlog = 1024);
                 Result<Socket> accept();
+                // accept4(2) variant: applies `flags` to the new socket atomically and
+                // reports the peer address when `peer_addr` is non-null.
+                Result<Socket> accept(Address* peer_addr, int flags = SOCK_NONBLOCK | SOCK_CLOEXEC);
                 Result<void> connect(const Address& addr);
                 Result<size_t> send(const void* data, size_t len);
                 Result<size_t> recv(void* data, size_t len);
+                // Gathered send of `count` buffers in one system call.
+                Result<size_t> sendv(const struct iovec* iov, size_t count);
                 Result<void> set_nonblocking(bool enable = true);
                 Result<void> set_reuseaddr(bool enable = true);
                 Result<void> set_reuseport(bool enable = true);
                 Result<void> set_nodelay(bool enable = true);
                 Result<void> set_keepalive(bool enable = true);
+                Result<void> set_defer_accept(int timeout_sec);
+                Result<void> set_fastopen(int queue_len);
+                Result<void> set_ipv6_only(bool enable = true);
+                Result<void> set_busy_poll(int usec);
+                Result<void> set_prefer_busy_poll(bool enable = true);
+                // Address the socket is bound to (getsockname); after binding port 0
+                // this carries the port the kernel picked.
+                Result<Address> local_address() const;
                 void shutdown_write();
                 void close();
 
                 int fd() const { return fd_; }
                 bool is_valid() const { return fd_ >= 0; }
-                static Result<Socket> create_tcp();
+                // Stream socket of the given family (AF_INET, AF_INET6 or AF_UNIX).
+                static Result<Socket> create_tcp(int family = AF_INET);
+                static Result<Socket> create_unix();
                 static Result<Socket> create_udp();
 
             public:
@@ -1,34 +1,97 @@
 #pragma once
 
+#include "../core/chunked_arena.h"
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace eventcore {
     namespace server {
 
+        enum class AffinityPolicy {
+            kNone,            // Leave thread placement to the scheduler
+            kPerCore,         // One worker event loop per logical CPU
+            kPerPhysicalCore  // One worker per physical core, skipping hyperthread siblings
+        };
+
         struct Config {
             std::string host = "0.0.0.0";
             uint16_t port = 8080;
             int backlog = 4096;  // Increased from 1024
 
+            // Listen specs such as "0.0.0.0:8080", "[::]:8080" or "unix:/run/eventcore.sock".
+            // When non-empty these replace host:port.
+            std::vector<std::string> listen_addresses;
+            // IPv6 listeners accept IPv4-mapped peers unless this is set.
+            bool ipv6_only = false;
+
             size_t num_workers = 0;
             size_t num_threads_per_worker = 4;
 
             size_t max_connections = 100000;  // Increased from 10000
             size_t connection_pool_size = 100000;  // NEW
+            // Backing for pooled Connection objects, committed 2 MB at a time
+            HugePageMode connection_huge_pages = HugePageMode::kTransparent;
 
-            size_t max_request_size = 1024 * 1024;
+            // Per-request limits enforced by the parser
+            size_t max_request_size = 1024 * 1024;  // Body bytes (413)
+            size_t max_request_line = 8 * 1024;     // 414
+            size_t max_header_count = 100;          // 431
+            size_t max_header_bytes = 32 * 1024;    // 431
             int keepalive_timeout_sec = 60;
 
-            size_t read_buffer_size = 4096;
+            size_t read_buffer_size = 4096;  // Slab size of the per-worker buffer pool
             size_t write_buffer_size = 4096;
 
             bool tcp_nodelay = true;
             bool tcp_reuseaddr = true;
             bool tcp_reuseport = true;  // Changed from false
 
+            // Only hand a connection to accept() once request bytes have arrived;
+            // idle connects are dropped by the kernel after this many seconds. 0 disables.
+            int tcp_defer_accept_sec = 0;
+
+            // Server-side TCP Fast Open: lets returning clients send the request in the SYN.
+            bool tcp_fastopen = false;
+            int tcp_fastopen_queue_len = 256;  // Max pending TFO requests not yet accepted
+
             int accept_batch_size = 100;  // NEW
 
+            // Counters, gauges and histograms in Server::metrics(). They are only
+            // served, in Prometheus text format, when metrics_path is set: the route
+            // answers on every listener, so expose it deliberately. An application
+            // route already registered at that path is left in place.
+            bool enable_metrics = true;
+            std::string metrics_path;
+            // With metrics on, warn when a worker's loop iteration or the wait of a ready
+            // connection for a pool thread exceeds this many milliseconds; 0 disables.
+            int loop_stall_threshold_ms = 0;
+
+            // Each worker keeps its last trace_buffer_events connection events (accept,
+            // first byte, parse, handler, write, close) in memory; 0 disables. A dump is
+            // served at trace_path (binary, or Chrome trace JSON with ?format=json;
+            // empty to skip the route) and written to trace_dump_file when the process
+            // receives trace_dump_signal, e.g. SIGUSR2 (0 installs no handler).
+            size_t trace_buffer_events = 16384;
+            std::string trace_path;
+            int trace_dump_signal = 0;
+            std::string trace_dump_file = "eventcore-trace.bin";
+
+            // CPU placement. Under a policy, worker i's loop is pinned to the policy's
+            // i-th CPU (wrapping when workers outnumber CPUs) and its connection objects
+            // and buffers are allocated on that CPU's NUMA node. With pin_thread_pools,
+            // pool threads run on the loop's hyperthread siblings (kPerPhysicalCore)
+            // or on the other CPUs of its node.
+            AffinityPolicy affinity = AffinityPolicy::kNone;
+            bool pin_thread_pools = true;
+
+            // Low-latency mode for dedicated cores: event loops spin on a zero-timeout
+            // poll for up to busy_poll_budget_us before blocking, and accepted sockets
+            // get SO_BUSY_POLL. Implies AffinityPolicy::kPerCore unless one is set.
+            bool busy_poll = false;
+            int busy_poll_budget_us = 50;
+            int so_busy_poll_us = 50;  // 0 leaves SO_BUSY_POLL unset on accepted sockets
+
             std::string log_file;
             std::string log_level = "info";
         };
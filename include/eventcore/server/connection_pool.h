@@ -2,39 +2,84 @@
 
 #include "../http/connection.h"
 #include "../core/noncopyable.h"
+#include "../core/chunked_arena.h"
+#include "../core/metrics.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include <mutex>
-#include <unordered_map>
-#include <chrono>
 
 namespace eventcore {
     namespace server {
 
+        // Connection slots split into one shard per worker. A shard is owned by
+        // its worker's event loop thread: acquire, release and lookups run there
+        // without locks, and other threads hand releases to the owner (see
+        // Worker). Only the availability counters may be read from anywhere.
         class ConnectionPool : public NonCopyable {
             public:
-                explicit ConnectionPool(size_t size);
-                ~ConnectionPool() = default;
+                class Shard : public NonCopyable {
+                    public:
+                        static constexpr uint32_t kNoSlot = UINT32_MAX;
 
-                http::ConnectionPtr acquire(int fd, http::Connection::RequestHandler handler);
-                void release(int fd);
+                        explicit Shard(size_t capacity, HugePageMode huge_pages = HugePageMode::kNone);
+                        // Unmaps the connections' memory, so no ConnectionPtr handed
+                        // out by acquire() may outlive the shard (asserted in debug builds).
+                        ~Shard();
 
-                size_t available() const;
-                size_t total_size() const { return pool_.size(); }
+                        // Binds `fd` to a free slot, constructing the Connection on
+                        // first use. Returns null when the shard is exhausted.
+                        http::ConnectionPtr acquire(int fd, const http::Connection::RequestHandler& handler,
+                                uint32_t* slot);
+                        // Frees `slot`; its fd mapping is dropped unless the fd has
+                        // since been bound to another slot.
+                        void release(uint32_t slot);
 
-                // Timeout management
-                std::vector<int> get_idle_connections(std::chrono::seconds timeout);
+                        uint32_t slot_of(int fd) const;
+                        int fd_of(uint32_t slot) const { return slots_[slot].fd; }
+                        const http::ConnectionPtr& connection(uint32_t slot) const { return slots_[slot].conn; }
+                        bool in_use(uint32_t slot) const { return slots_[slot].in_use; }
 
-            private:
-                struct PoolEntry {
-                    http::ConnectionPtr conn;
-                    std::chrono::steady_clock::time_point last_used;
-                    bool in_use;
+                        size_t capacity() const { return slots_.size(); }
+                        size_t available() const { return available_.load(std::memory_order_relaxed); }
+                        size_t active() const { return capacity() - available(); }
+                        size_t committed_bytes() const { return arena_.committed_bytes(); }
+
+                    private:
+                        struct Slot {
+                            http::ConnectionPtr conn;
+                            int fd = -1;
+                            bool in_use = false;
+                        };
+
+                        // Connection objects live in the arena at their slot index, so
+                        // they sit contiguously and memory is committed as slots are used.
+                        ChunkedArena arena_;
+                        std::vector<Slot> slots_;
+                        std::vector<uint32_t> free_list_;   // Owner thread only
+                        std::vector<uint32_t> fd_to_slot_;  // Dense, indexed by fd
+                        std::atomic<size_t> available_;
                 };
 
-                std::vector<PoolEntry> pool_;
-                std::vector<size_t> free_indices_;
-                std::unordered_map<int, size_t> fd_to_index_;
-                mutable std::mutex mutex_;
+                // Slots are split evenly across `num_shards`.
+                explicit ConnectionPool(size_t size, size_t num_shards = 1,
+                        HugePageMode huge_pages = HugePageMode::kNone);
+                ~ConnectionPool() = default;
+
+                Shard& shard(size_t index) { return *shards_[index % shards_.size()]; }
+                const Shard& shard(size_t index) const { return *shards_[index % shards_.size()]; }
+                size_t num_shards() const { return shards_.size(); }
+
+                size_t available() const;
+                size_t available(size_t shard) const { return this->shard(shard).available(); }
+                size_t total_size() const { return total_size_; }
+                size_t committed_bytes() const;
+                // Per-shard capacity, free slots and committed memory, sampled on scrape
+                void register_metrics(metrics::Registry& registry) const;
+
+            private:
+                std::vector<std::unique_ptr<Shard>> shards_;
+                size_t total_size_;
         };
 
     } // namespace server
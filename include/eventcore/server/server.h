@@ -1,6 +1,7 @@
 #pragma once
 #include "../core/noncopyable.h"
 #include "../net/socket.h"
+#include "../net/poller.h"
 #include "../http/router.h"
 #include "connection_pool.h"
 #include "config.h"
@@ -8,6 +9,10 @@
 #include <memory>
 #include <vector>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <signal.h>
 
 namespace eventcore {
     namespace server {
@@ -22,20 +27,68 @@ namespace eventcore {
                 http::Router& router() { return router_; }
                 const Config& config() const { return config_; }
                 bool is_running() const { return running_; }
+                // Address listener `index` (in listen order) is bound to, with the port
+                // the kernel picked when configured as 0. Port 0 while stopped.
+                net::Address local_address(size_t index = 0) const;
+                std::vector<net::Address> local_addresses() const;
+                // Blocks until start(), possibly running on another thread, has bound
+                // every listener and started the workers; false on timeout.
+                bool wait_until_ready(std::chrono::milliseconds timeout) const;
+                std::vector<LoopStats> worker_loop_stats() const;
+                size_t active_connections() const;
+                // Occupancy of the per-worker buffer pools, summed.
+                net::SlabPoolStats buffer_pool_stats() const;
+                // Server-wide metrics, also served at Config::metrics_path when set
+                metrics::Registry& metrics() { return metrics_; }
+                // Flight recorder contents of all workers, in time order
+                std::vector<trace::Event> trace_events() const;
+                Result<void> dump_trace(const std::string& path) const;
 
             private:
                 void accept_loop();
-                void handle_new_connection(net::Socket client_socket);
+                void register_metrics();
+                void register_builtin_routes();
+                void register_trace_route();
+                struct Listener {
+                    net::Address address;
+                    net::Socket socket;
+                    // The socket file bound for a unix path, so stop() removes
+                    // only that one; 0 otherwise
+                    dev_t unix_dev = 0;
+                    ino_t unix_ino = 0;
+                };
+
+                Listener open_listener(const net::Address& addr);
+                void handle_accept(Listener& listener);
+                void handle_new_connection(net::Socket client_socket, const net::Address& peer);
                 Worker* next_worker();
 
                 Config config_;
+                // Declared early: samplers registered by the members below are
+                // destroyed before the registry.
+                metrics::Registry metrics_;
+                metrics::Counter* accepted_ = nullptr;
+                metrics::Counter* accept_errors_ = nullptr;
+                std::vector<WorkerOptions> worker_options_;
+                // One slab pool per worker, declared before pool_ so the pooled
+                // connections' buffers are released while the slab pools still exist.
+                std::vector<std::unique_ptr<net::SlabPool>> buffer_pools_;
                 ConnectionPool pool_;
                 http::Router router_;
-                net::Socket listen_socket_;
+                std::vector<Listener> listeners_;
+                std::unique_ptr<net::Poller> accept_poller_;
                 std::vector<std::unique_ptr<Worker>> workers_;
                 std::thread accept_thread_;
                 std::atomic<bool> running_{false};
                 std::atomic<size_t> next_worker_idx_{0};
+                // Bound addresses, published once start() has finished
+                mutable std::mutex ready_mutex_;
+                mutable std::condition_variable ready_cv_;
+                bool ready_ = false;
+                std::vector<net::Address> local_addresses_;
+                struct sigaction previous_trace_action_;
+                bool trace_signal_installed_ = false;
+                bool builtin_routes_registered_ = false;
         };
 
     } // namespace server
@@ -1,42 +1,122 @@
 #pragma once
 #include "../core/noncopyable.h"
+#include "../core/trace.h"
 #include "../net/poller.h"
 #include "../http/connection.h"
 #include "../http/router.h"
 #include "../thread/thread_pool.h"
 #include "connection_pool.h"
 #include <memory>
-#include <unordered_map>
+#include <vector>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 
 namespace eventcore {
     namespace server {
 
+        struct WorkerOptions {
+            bool busy_poll = false;
+            std::chrono::microseconds busy_poll_budget{50};
+            int cpu = -1;                // CPU the event loop thread is pinned to; -1 leaves it unpinned
+            std::vector<int> pool_cpus;  // CPUs for the worker's thread pool; empty leaves them unpinned
+            int numa_node = -1;          // Preferred memory node for the loop thread; -1 for none
+            size_t pool_shard = 0;       // ConnectionPool shard this worker owns
+            std::chrono::seconds idle_timeout{60};  // Keep-alive connections idle longer are closed
+            http::ParserLimits parser_limits;
+            metrics::Registry* metrics = nullptr;   // Registry the worker reports into; must outlive it
+            // A loop iteration, or the handoff of a ready connection to a pool thread,
+            // taking longer than this is counted as a stall and logged; 0 disables.
+            std::chrono::milliseconds stall_threshold{0};
+            size_t trace_capacity = 0;              // Flight recorder events kept; 0 disables tracing
+        };
+
+        // Where the event loop spends its time in busy-poll mode. Spin time is
+        // zero-timeout polls that found nothing; work time is polls that
+        // dispatched events. A spin miss is a budget that expired without events.
+        struct LoopStats {
+            uint64_t spin_ns = 0;
+            uint64_t work_ns = 0;
+            uint64_t spin_hits = 0;
+            uint64_t spin_misses = 0;
+        };
+
         class Worker : public NonCopyable {
             public:
-                Worker(const http::Router* router, size_t thread_pool_size = 4, ConnectionPool* pool = nullptr);
+                // `buffer_pool` supplies the connection buffers' slabs and must outlive
+                // `pool`; null selects the process-wide default pool.
+                Worker(const http::Router* router, size_t thread_pool_size = 4, ConnectionPool* pool = nullptr,
+                        const WorkerOptions& options = WorkerOptions(), net::SlabPool* buffer_pool = nullptr);
                 ~Worker();
                 void start();
                 void stop();
-                void add_connection(http::ConnectionPtr conn);
-                size_t connection_count() const { return connections_.size(); }
+                // Hands an accepted socket to the worker. Callable from any thread; the
+                // connection object is acquired and registered on the worker's own loop
+                // thread so its memory is first touched on the worker's NUMA node.
+                void add_connection(net::Socket socket);
+                size_t connection_count() const { return shard_->active(); }
                 bool is_running() const { return running_; }
+                LoopStats loop_stats() const;
+                // Null unless WorkerOptions::trace_capacity is set
+                const trace::FlightRecorder* flight_recorder() const { return recorder_.get(); }
 
             private:
                 void event_loop();
-                void handle_connection_event(int fd, int events);
-                void remove_connection(int fd);
+                int busy_poll();
+                void handle_wakeup();
+                void register_connection(int fd);
+                void handle_connection_event(uint32_t slot, int events);
+                // Queues `slot` for release on the loop thread; callable from any thread.
+                void post_release(uint32_t slot);
+                void release_connection(uint32_t slot);
                 void check_idle_connections();
+                void register_metrics(metrics::Registry& registry);
+                void register_route_metrics(metrics::Registry& registry);
+                void record_iteration(int num_events);
+                // Counts and, at most once a second, logs a delay over the stall threshold
+                void check_stall(const char* what, std::chrono::steady_clock::duration delay);
+                http::Response handle_request(const http::Request& request);
 
-                ConnectionPool* pool_;
+                ConnectionPool::Shard* shard_;
+                net::SlabPool* buffer_pool_;
                 std::chrono::steady_clock::time_point last_timeout_check_;
                 const http::Router* router_;
+                WorkerOptions options_;
                 std::unique_ptr<net::Poller> poller_;
                 std::unique_ptr<thread::ThreadPool> thread_pool_;
-                std::unordered_map<int, http::ConnectionPtr> connections_;
+                http::Connection::RequestHandler request_handler_;
+                int wakeup_fd_ = -1;
+#ifndef __linux__
+                int wakeup_write_fd_ = -1;
+#endif
+                std::vector<int> pending_fds_;
+                std::vector<uint32_t> pending_releases_;
+                std::mutex pending_mutex_;
                 std::thread event_thread_;
                 std::atomic<bool> running_{false};
-                mutable std::mutex mutex_;
+                std::unique_ptr<trace::FlightRecorder> recorder_;
+                uint64_t next_connection_id_ = 0;  // Loop thread only
+
+                std::atomic<uint64_t> spin_ns_{0};
+                std::atomic<uint64_t> work_ns_{0};
+                std::atomic<uint64_t> spin_hits_{0};
+                std::atomic<uint64_t> spin_misses_{0};
+
+                http::ConnectionMetrics connection_metrics_;
+                metrics::Counter* poll_events_ = nullptr;
+                metrics::Counter* idle_closes_ = nullptr;
+                // Handler latency by route id; the last entry takes unmatched requests
+                // and routes added after start(). Built once, before pool threads run.
+                std::vector<metrics::LatencyHistogram*> handler_latency_;
+
+                // Event loop health: how long an iteration takes from wake-up to the
+                // next poll, how many events each poll returns, and how long a ready
+                // connection waits before a pool thread starts on it.
+                metrics::LatencyHistogram* loop_iteration_ = nullptr;
+                metrics::Histogram* events_per_poll_ = nullptr;
+                metrics::LatencyHistogram* readiness_lag_ = nullptr;
+                metrics::Counter* stalls_ = nullptr;
+                std::atomic<std::chrono::steady_clock::rep> last_stall_log_{0};
         };
 
     } // namespace server
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace eventcore {
+    namespace thread {
+
+        struct CpuInfo {
+            int cpu = 0;
+            int core_id = 0;
+            int package_id = 0;
+            int node = 0;
+        };
+
+        // Snapshot of the CPUs this process may run on, read from sysfs. On systems
+        // without topology information every CPU is its own core on node 0.
+        class CpuTopology {
+            public:
+                static CpuTopology detect();
+
+                const std::vector<CpuInfo>& cpus() const { return cpus_; }
+                std::vector<int> logical_cpus() const;
+                // First allowed hyperthread of every physical core.
+                std::vector<int> physical_cores() const;
+                // Other allowed hyperthreads sharing `cpu`'s physical core.
+                std::vector<int> siblings_of(int cpu) const;
+                std::vector<int> cpus_on_node(int node) const;
+                int node_of(int cpu) const;
+                size_t num_nodes() const;
+
+            private:
+                std::vector<CpuInfo> cpus_;
+        };
+
+        // Number of CPUs the process may run on (honours cgroup/taskset masks).
+        size_t available_cpu_count();
+
+        // Pins the calling thread to a single CPU. Returns false when the CPU is
+        // outside the allowed set or the platform has no affinity support.
+        bool pin_current_thread(int cpu);
+        bool pin_current_thread(const std::vector<int>& cpus);
+
+        // Makes `node` the preferred NUMA node for the calling thread's future page
+        // allocations, so objects it first touches stay local even under memory
+        // pressure on that node's neighbours. No-op without NUMA support.
+        bool prefer_memory_node(int node);
+
+    } // namespace thread
+} // namespace eventcore
@@ -1,10 +1,12 @@
 #pragma once
 #include "blocking_queue.h"
 #include "../core/noncopyable.h"
+#include "../core/metrics.h"
 #include <vector>
 #include <thread>
 #include <functional>
 #include <atomic>
+#include <chrono>
 
 namespace eventcore {
     namespace thread {
@@ -17,14 +19,27 @@ namespace eventcore {
                 void start();
                 void stop();
                 void submit(Task task);
+                // CPUs the pool threads may run on; takes effect on the next start().
+                void set_cpu_affinity(std::vector<int> cpus) { cpu_affinity_ = std::move(cpus); }
                 size_t size() const { return threads_.size(); }
                 size_t pending_tasks() const { return tasks_.size(); }
+                // Exports queue depth, completed tasks and the time tasks wait in the
+                // queue; call before start(). The pool must outlive `registry`'s scrapes.
+                void register_metrics(metrics::Registry& registry, const metrics::Labels& labels);
 
             private:
+                struct QueuedTask {
+                    Task task;
+                    std::chrono::steady_clock::time_point enqueued;  // Only set when queue wait is measured
+                };
+
                 void worker_thread();
                 std::vector<std::thread> threads_;
-                BlockingQueue<Task> tasks_;
+                BlockingQueue<QueuedTask> tasks_;
+                std::vector<int> cpu_affinity_;
                 std::atomic<bool> running_{false};
+                metrics::Counter* tasks_completed_ = nullptr;
+                metrics::LatencyHistogram* queue_wait_ = nullptr;
         };
 
     } // namespace thread
@@ -0,0 +1,245 @@
+#include "eventcore/core/alloc_counter.h"
+
+#ifdef EVENTCORE_ALLOC_COUNTING
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace eventcore {
+    namespace alloc {
+
+        Stats operator-(const Stats& a, const Stats& b) {
+            Stats d;
+            d.allocations = a.allocations - b.allocations;
+            d.deallocations = a.deallocations - b.deallocations;
+            d.bytes = a.bytes - b.bytes;
+            return d;
+        }
+
+#ifndef EVENTCORE_ALLOC_COUNTING
+
+        bool counting_enabled() { return false; }
+        Stats thread_stats() { return Stats(); }
+        Stats process_stats() { return Stats(); }
+
+#else
+
+        namespace {
+
+            // Process totals are split into shards like metrics::Counter, so
+            // threads allocating concurrently do not bounce one cache line.
+            constexpr size_t kShards = 32;
+
+            struct Cell {
+                std::atomic<uint64_t> allocations;
+                std::atomic<uint64_t> deallocations;
+                std::atomic<uint64_t> bytes;
+                char pad[64 - 3 * sizeof(std::atomic<uint64_t>)];
+            };
+            Cell cells[kShards];
+            std::atomic<size_t> next_shard{0};
+
+            struct ThreadCounts {
+                uint64_t allocations;
+                uint64_t deallocations;
+                uint64_t bytes;
+                size_t shard;  // Plus one; 0 until assigned
+            };
+
+            // Initial-exec TLS is reached without calling into the dynamic
+            // linker, which may itself allocate.
+            thread_local ThreadCounts thread_counts __attribute__((tls_model("initial-exec")));
+
+            Cell& thread_cell() {
+                ThreadCounts& t = thread_counts;
+                if (t.shard == 0) t.shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards + 1;
+                return cells[t.shard - 1];
+            }
+
+            void count_allocation(size_t size) {
+                thread_counts.allocations++;
+                thread_counts.bytes += size;
+                Cell& cell = thread_cell();
+                cell.allocations.fetch_add(1, std::memory_order_relaxed);
+                cell.bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+
+            void count_deallocation() {
+                thread_counts.deallocations++;
+                thread_cell().deallocations.fetch_add(1, std::memory_order_relaxed);
+            }
+
+        } // namespace
+
+        bool counting_enabled() { return true; }
+
+        Stats thread_stats() {
+            Stats stats;
+            stats.allocations = thread_counts.allocations;
+            stats.deallocations = thread_counts.deallocations;
+            stats.bytes = thread_counts.bytes;
+            return stats;
+        }
+
+        Stats process_stats() {
+            Stats stats;
+            for (const Cell& cell : cells) {
+                stats.allocations += cell.allocations.load(std::memory_order_relaxed);
+                stats.deallocations += cell.deallocations.load(std::memory_order_relaxed);
+                stats.bytes += cell.bytes.load(std::memory_order_relaxed);
+            }
+            return stats;
+        }
+
+#endif
+
+    } // namespace alloc
+} // namespace eventcore
+
+#ifdef EVENTCORE_ALLOC_COUNTING
+
+// Replacements are exported so they also interpose from the shared library
+#define EVENTCORE_INTERPOSE __attribute__((visibility("default")))
+
+#ifdef __GLIBC__
+// glibc's own allocator entry points, so malloc can be replaced as well
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t align, size_t size);
+    void __libc_free(void* ptr);
+}
+
+namespace {
+    void* raw_malloc(size_t size) { return __libc_malloc(size); }
+    void* raw_aligned(size_t align, size_t size) { return __libc_memalign(align, size); }
+    void raw_free(void* ptr) { __libc_free(ptr); }
+}
+
+extern "C" {
+
+    EVENTCORE_INTERPOSE void* malloc(size_t size) noexcept {
+        eventcore::alloc::count_allocation(size);
+        return __libc_malloc(size);
+    }
+
+    EVENTCORE_INTERPOSE void* calloc(size_t count, size_t size) noexcept {
+        size_t bytes;
+        // An overflowing request fails in calloc and is not counted
+        if (!__builtin_mul_overflow(count, size, &bytes)) eventcore::alloc::count_allocation(bytes);
+        return __libc_calloc(count, size);
+    }
+
+    EVENTCORE_INTERPOSE void* realloc(void* ptr, size_t size) noexcept {
+        if (ptr) eventcore::alloc::count_deallocation();
+        eventcore::alloc::count_allocation(size);
+        return __libc_realloc(ptr, size);
+    }
+
+    EVENTCORE_INTERPOSE void free(void* ptr) noexcept {
+        if (!ptr) return;
+        eventcore::alloc::count_deallocation();
+        __libc_free(ptr);
+    }
+
+    EVENTCORE_INTERPOSE void* memalign(size_t align, size_t size) noexcept {
+        eventcore::alloc::count_allocation(size);
+        return __libc_memalign(align, size);
+    }
+
+    EVENTCORE_INTERPOSE void* aligned_alloc(size_t align, size_t size) noexcept {
+        eventcore::alloc::count_allocation(size);
+        return __libc_memalign(align, size);
+    }
+
+    EVENTCORE_INTERPOSE int posix_memalign(void** out, size_t align, size_t size) noexcept {
+        if (align < sizeof(void*) || (align & (align - 1)) != 0) return EINVAL;
+        eventcore::alloc::count_allocation(size);
+        void* ptr = __libc_memalign(align, size);
+        if (!ptr) return ENOMEM;
+        *out = ptr;
+        return 0;
+    }
+
+}
+#else
+namespace {
+    void* raw_malloc(size_t size) { return std::malloc(size); }
+    void* raw_aligned(size_t align, size_t size) {
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, align, size) == 0 ? ptr : nullptr;
+    }
+    void raw_free(void* ptr) { std::free(ptr); }
+}
+#endif
+
+namespace {
+
+    // operator new goes straight to the underlying allocator, so an
+    // allocation is counted once whether or not malloc is replaced too.
+    // `align` is 0 for the unaligned forms.
+    void* counted_new(size_t size, size_t align = 0) {
+        if (size == 0) size = 1;
+        eventcore::alloc::count_allocation(size);
+        while (true) {
+            void* ptr = align ? raw_aligned(align, size) : raw_malloc(size);
+            if (ptr) return ptr;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* counted_new_nothrow(size_t size, size_t align = 0) noexcept {
+        try {
+            return counted_new(size, align);
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    void counted_delete(void* ptr) noexcept {
+        if (!ptr) return;
+        eventcore::alloc::count_deallocation();
+        raw_free(ptr);
+    }
+
+} // namespace
+
+EVENTCORE_INTERPOSE void* operator new(size_t size) { return counted_new(size); }
+EVENTCORE_INTERPOSE void* operator new[](size_t size) { return counted_new(size); }
+EVENTCORE_INTERPOSE void* operator new(size_t size, const std::nothrow_t&) noexcept { return counted_new_nothrow(size); }
+EVENTCORE_INTERPOSE void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_new_nothrow(size); }
+EVENTCORE_INTERPOSE void operator delete(void* ptr) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete[](void* ptr) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete(void* ptr, size_t) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete[](void* ptr, size_t) noexcept { counted_delete(ptr); }
+
+// Over-aligned forms; CMake compiles this file with aligned new enabled
+#ifdef __cpp_aligned_new
+EVENTCORE_INTERPOSE void* operator new(size_t size, std::align_val_t align) {
+    return counted_new(size, static_cast<size_t>(align));
+}
+EVENTCORE_INTERPOSE void* operator new[](size_t size, std::align_val_t align) {
+    return counted_new(size, static_cast<size_t>(align));
+}
+EVENTCORE_INTERPOSE void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return counted_new_nothrow(size, static_cast<size_t>(align));
+}
+EVENTCORE_INTERPOSE void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return counted_new_nothrow(size, static_cast<size_t>(align));
+}
+EVENTCORE_INTERPOSE void operator delete(void* ptr, std::align_val_t) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete[](void* ptr, std::align_val_t) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete(void* ptr, size_t, std::align_val_t) noexcept { counted_delete(ptr); }
+EVENTCORE_INTERPOSE void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { counted_delete(ptr); }
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+#include "eventcore/core/chunked_arena.h"
+#include "eventcore/core/logger.h"
+#include <sys/mman.h>
+#include <cstdint>
+#include <new>
+
+namespace eventcore {
+
+    constexpr size_t ChunkedArena::kChunkSize;
+    constexpr size_t ChunkedArena::kSlotAlign;
+
+    ChunkedArena::ChunkedArena(size_t object_size, size_t capacity, HugePageMode mode)
+        : stride_((object_size + kSlotAlign - 1) / kSlotAlign * kSlotAlign),
+        capacity_(capacity),
+        mode_(mode) {
+            if (stride_ == 0) stride_ = kSlotAlign;
+            size_t chunks = (stride_ * capacity_ + kChunkSize - 1) / kChunkSize;
+            reserved_ = chunks * kChunkSize;
+            committed_.resize(chunks, false);
+            if (reserved_ == 0) return;
+
+            // Over-reserve by one chunk so the usable range can start on a huge page boundary
+            mapping_size_ = reserved_ + kChunkSize;
+            mapping_ = mmap(nullptr, mapping_size_, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (mapping_ == MAP_FAILED) {
+                mapping_ = nullptr;
+                throw std::bad_alloc();
+            }
+
+            uintptr_t addr = reinterpret_cast<uintptr_t>(mapping_);
+            uintptr_t aligned = (addr + kChunkSize - 1) / kChunkSize * kChunkSize;
+            base_ = reinterpret_cast<char*>(aligned);
+        }
+
+    ChunkedArena::~ChunkedArena() {
+        if (mapping_) munmap(mapping_, mapping_size_);
+    }
+
+    void* ChunkedArena::slot(size_t index) {
+        if (index >= capacity_) return nullptr;
+
+        // A slot can straddle two chunks when the stride does not divide kChunkSize
+        size_t first = index * stride_ / kChunkSize;
+        size_t last = (index * stride_ + stride_ - 1) / kChunkSize;
+        for (size_t chunk = first; chunk <= last; ++chunk) {
+            if (!committed_[chunk] && !commit(chunk)) return nullptr;
+        }
+        return base_ + index * stride_;
+    }
+
+    bool ChunkedArena::commit(size_t chunk) {
+        char* addr = base_ + chunk * kChunkSize;
+        bool remap = false;
+
+#if defined(MAP_HUGETLB) && defined(MAP_FIXED)
+        if (mode_ == HugePageMode::kExplicit) {
+            void* huge = mmap(addr, kChunkSize, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0);
+            if (huge != MAP_FAILED) {
+                committed_[chunk] = true;
+                ++committed_chunks_;
+                ++huge_chunks_;
+                return true;
+            }
+            LOG_DEBUG("No explicit huge page available, committing chunk ", chunk, " with regular pages");
+            // The failed MAP_FIXED may already have unmapped the range from the
+            // reservation, which mprotect cannot repair; map it again in place.
+            remap = true;
+        }
+#endif
+
+        if (remap) {
+            void* regular = mmap(addr, kChunkSize, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+            if (regular == MAP_FAILED) return false;
+        } else if (mprotect(addr, kChunkSize, PROT_READ | PROT_WRITE) != 0) {
+            return false;
+        }
+#ifdef MADV_HUGEPAGE
+        if (mode_ != HugePageMode::kNone && madvise(addr, kChunkSize, MADV_HUGEPAGE) == 0) {
+            ++huge_chunks_;
+        }
+#endif
+        committed_[chunk] = true;
+        ++committed_chunks_;
+        return true;
+    }
+
+} // namespace eventcore
@@ -0,0 +1,324 @@
+#include "eventcore/core/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace eventcore {
+    namespace metrics {
+
+        namespace {
+
+            std::atomic<size_t> next_shard{0};
+
+            std::string render_labels(const Labels& labels) {
+                std::string out;
+                for (const auto& label : labels) {
+                    if (!out.empty()) out += ',';
+                    out += label.first;
+                    out += "=\"";
+                    for (char c : label.second) {
+                        if (c == '\\') out += "\\\\";
+                        else if (c == '"') out += "\\\"";
+                        else if (c == '\n') out += "\\n";
+                        else out += c;
+                    }
+                    out += '"';
+                }
+                return out;
+            }
+
+            void append_number(std::string& out, double value) {
+                char buf[32];
+                int n;
+                if (std::isinf(value)) {
+                    out += value > 0 ? "+Inf" : "-Inf";
+                    return;
+                }
+                if (value == std::floor(value) && std::fabs(value) < 1e15) {
+                    n = std::snprintf(buf, sizeof(buf), "%.0f", value);
+                } else {
+                    n = std::snprintf(buf, sizeof(buf), "%.9g", value);
+                }
+                out.append(buf, static_cast<size_t>(n));
+            }
+
+            void append_sample(std::string& out, const std::string& name, const char* suffix,
+                    const std::string& labels, const std::string& extra_label, double value) {
+                out += name;
+                out += suffix;
+                if (!labels.empty() || !extra_label.empty()) {
+                    out += '{';
+                    out += labels;
+                    if (!labels.empty() && !extra_label.empty()) out += ',';
+                    out += extra_label;
+                    out += '}';
+                }
+                out += ' ';
+                append_number(out, value);
+                out += '\n';
+            }
+
+            const char* type_name(MetricType type) {
+                switch (type) {
+                    case MetricType::kCounter: return "counter";
+                    case MetricType::kGauge: return "gauge";
+                    case MetricType::kHistogram: return "histogram";
+                    case MetricType::kSummary: return "summary";
+                }
+                return "untyped";
+            }
+
+        } // namespace
+
+        size_t this_thread_shard() {
+            static thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+            return shard;
+        }
+
+        uint64_t Counter::value() const {
+            uint64_t total = 0;
+            for (const Cell& cell : cells_) total += cell.value.load(std::memory_order_relaxed);
+            return total;
+        }
+
+        Histogram::Histogram(std::vector<uint64_t> bounds, double scale)
+            : bounds_(std::move(bounds)), scale_(scale) {
+                std::sort(bounds_.begin(), bounds_.end());
+                bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
+                const size_t per_line = 64 / sizeof(std::atomic<uint64_t>);
+                stride_ = (bounds_.size() + 2 + per_line - 1) / per_line * per_line;
+                cells_.reset(new std::atomic<uint64_t>[kShards * stride_]());
+            }
+
+        void Histogram::observe(uint64_t value) {
+            std::atomic<uint64_t>* cells = &cells_[this_thread_shard() * stride_];
+            const size_t bucket = static_cast<size_t>(
+                    std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+            cells[bucket].fetch_add(1, std::memory_order_relaxed);
+            cells[bounds_.size() + 1].fetch_add(value, std::memory_order_relaxed);
+        }
+
+        Histogram::Snapshot Histogram::snapshot() const {
+            Snapshot snap;
+            snap.bounds = bounds_;
+            snap.counts.assign(bounds_.size() + 1, 0);
+            for (size_t shard = 0; shard < kShards; ++shard) {
+                const std::atomic<uint64_t>* cells = &cells_[shard * stride_];
+                for (size_t i = 0; i <= bounds_.size(); ++i) {
+                    snap.counts[i] += cells[i].load(std::memory_order_relaxed);
+                }
+                snap.sum += cells[bounds_.size() + 1].load(std::memory_order_relaxed);
+            }
+            for (uint64_t c : snap.counts) snap.count += c;
+            return snap;
+        }
+
+        std::vector<uint64_t> Histogram::latency_buckets_ns() {
+            return {50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000,
+                25000000, 50000000, 100000000, 250000000, 500000000, 1000000000, 2500000000,
+                10000000000};
+        }
+
+        constexpr int LatencyHistogram::kSubBucketBits;
+        constexpr int LatencyHistogram::kMaxBits;
+        constexpr size_t LatencyHistogram::kBuckets;
+
+        LatencyHistogram::LatencyHistogram() : buckets_(new std::atomic<uint64_t>[kBuckets]()) {}
+
+        size_t LatencyHistogram::bucket_of(uint64_t value) {
+            const uint64_t linear = uint64_t(1) << kSubBucketBits;
+            if (value < linear) return value;
+            const int msb = 63 - __builtin_clzll(value);
+            if (msb >= kMaxBits) return kBuckets - 1;
+            // The top kSubBucketBits bits of the value, leading one included, pick
+            // one of 32 equal-width buckets within the octave.
+            const int shift = msb - kSubBucketBits + 1;
+            return static_cast<size_t>(shift) * (linear / 2) + (value >> shift);
+        }
+
+        uint64_t LatencyHistogram::bucket_upper(size_t bucket) {
+            const size_t linear = size_t(1) << kSubBucketBits;
+            if (bucket < linear) return bucket;
+            const size_t half = linear / 2;
+            const size_t shift = bucket / half - 1;
+            const uint64_t mantissa = bucket % half + half;
+            return ((mantissa + 1) << shift) - 1;
+        }
+
+        void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+            for (size_t i = 0; i < kBuckets; ++i) counts[i] += other.counts[i];
+            count += other.count;
+            sum += other.sum;
+        }
+
+        uint64_t LatencyHistogram::Snapshot::quantile(double q) const {
+            if (count == 0) return 0;
+            uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+            if (rank == 0) rank = 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                seen += counts[i];
+                if (seen >= rank) return bucket_upper(i);
+            }
+            return bucket_upper(kBuckets - 1);
+        }
+
+        LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+            Snapshot snap;
+            merge_into(&snap);
+            return snap;
+        }
+
+        void LatencyHistogram::merge_into(Snapshot* snapshot) const {
+            for (size_t i = 0; i < kBuckets; ++i) {
+                const uint64_t n = buckets_[i].load(std::memory_order_relaxed);
+                snapshot->counts[i] += n;
+                snapshot->count += n;
+            }
+            snapshot->sum += sum_.load(std::memory_order_relaxed);
+        }
+
+        Registry::Series& Registry::series(const std::string& name, const std::string& help,
+                MetricType type, const Labels& labels, bool* created) {
+            auto it = index_.find(name);
+            if (it == index_.end()) {
+                it = index_.emplace(name, families_.size()).first;
+                families_.push_back(Family{name, help, type, {}});
+            }
+            Family& family = families_[it->second];
+            if (family.type != type) {
+                throw std::invalid_argument("metric " + name + " registered with two types");
+            }
+            const std::string rendered = render_labels(labels);
+            for (Series& s : family.series) {
+                if (s.labels == rendered) {
+                    *created = false;
+                    return s;
+                }
+            }
+            family.series.push_back(Series());
+            family.series.back().labels = rendered;
+            *created = true;
+            return family.series.back();
+        }
+
+        Counter& Registry::counter(const std::string& name, const std::string& help, const Labels& labels) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool created;
+            Series& s = series(name, help, MetricType::kCounter, labels, &created);
+            if (!s.counter) {
+                if (!created) throw std::invalid_argument("metric " + name + " is sampled, not recorded");
+                s.counter.reset(new Counter());
+            }
+            return *s.counter;
+        }
+
+        Gauge& Registry::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool created;
+            Series& s = series(name, help, MetricType::kGauge, labels, &created);
+            if (!s.gauge) {
+                if (!created) throw std::invalid_argument("metric " + name + " is sampled, not recorded");
+                s.gauge.reset(new Gauge());
+            }
+            return *s.gauge;
+        }
+
+        Histogram& Registry::histogram(const std::string& name, const std::string& help,
+                std::vector<uint64_t> bounds, double scale, const Labels& labels) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool created;
+            Series& s = series(name, help, MetricType::kHistogram, labels, &created);
+            if (!s.histogram) s.histogram.reset(new Histogram(std::move(bounds), scale));
+            return *s.histogram;
+        }
+
+        void Registry::gauge_fn(const std::string& name, const std::string& help, const Labels& labels,
+                Sampler sampler) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool created;
+            Series& s = series(name, help, MetricType::kGauge, labels, &created);
+            s.gauge.reset();
+            s.sampler = std::move(sampler);
+        }
+
+        void Registry::counter_fn(const std::string& name, const std::string& help, const Labels& labels,
+                Sampler sampler) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool created;
+            Series& s = series(name, help, MetricType::kCounter, labels, &created);
+            s.counter.reset();
+            s.sampler = std::move(sampler);
+        }
+
+        LatencyHistogram& Registry::latency(const std::string& name, const std::string& help,
+                const Labels& labels, double scale) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool created;
+            Series& s = series(name, help, MetricType::kSummary, labels, &created);
+            s.latency_scale = scale;
+            s.latencies.emplace_back(new LatencyHistogram());
+            return *s.latencies.back();
+        }
+
+        void Registry::latency_view(const std::string& name, const std::string& help, const Labels& labels,
+                const std::vector<const LatencyHistogram*>& parts, double scale) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool created;
+            Series& s = series(name, help, MetricType::kSummary, labels, &created);
+            s.latency_scale = scale;
+            s.latency_views.insert(s.latency_views.end(), parts.begin(), parts.end());
+        }
+
+        std::string Registry::render() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::string out;
+            out.reserve(4096);
+            for (const Family& family : families_) {
+                out += "# HELP " + family.name + ' ' + family.help + '\n';
+                out += "# TYPE " + family.name + ' ' + type_name(family.type) + '\n';
+                for (const Series& s : family.series) {
+                    if (s.sampler) {
+                        append_sample(out, family.name, "", s.labels, "", s.sampler());
+                    } else if (s.counter) {
+                        append_sample(out, family.name, "", s.labels, "", static_cast<double>(s.counter->value()));
+                    } else if (s.gauge) {
+                        append_sample(out, family.name, "", s.labels, "", static_cast<double>(s.gauge->value()));
+                    } else if (s.histogram) {
+                        const Histogram::Snapshot snap = s.histogram->snapshot();
+                        const double scale = s.histogram->scale();
+                        uint64_t cumulative = 0;
+                        std::string le;
+                        for (size_t i = 0; i < snap.counts.size(); ++i) {
+                            cumulative += snap.counts[i];
+                            le = "le=\"";
+                            if (i < snap.bounds.size()) append_number(le, static_cast<double>(snap.bounds[i]) * scale);
+                            else le += "+Inf";
+                            le += '"';
+                            append_sample(out, family.name, "_bucket", s.labels, le, static_cast<double>(cumulative));
+                        }
+                        append_sample(out, family.name, "_sum", s.labels, "", static_cast<double>(snap.sum) * scale);
+                        append_sample(out, family.name, "_count", s.labels, "", static_cast<double>(snap.count));
+                    } else if (!s.latencies.empty() || !s.latency_views.empty()) {
+                        LatencyHistogram::Snapshot snap;
+                        for (const auto& latency : s.latencies) latency->merge_into(&snap);
+                        for (const LatencyHistogram* latency : s.latency_views) latency->merge_into(&snap);
+                        static const struct { double q; const char* label; } kQuantiles[] = {
+                            {0.5, "quantile=\"0.5\""}, {0.9, "quantile=\"0.9\""},
+                            {0.99, "quantile=\"0.99\""}, {0.999, "quantile=\"0.999\""},
+                        };
+                        for (const auto& q : kQuantiles) {
+                            append_sample(out, family.name, "", s.labels, q.label,
+                                    static_cast<double>(snap.quantile(q.q)) * s.latency_scale);
+                        }
+                        append_sample(out, family.name, "_sum", s.labels, "", static_cast<double>(snap.sum) * s.latency_scale);
+                        append_sample(out, family.name, "_count", s.labels, "", static_cast<double>(snap.count));
+                    }
+                }
+            }
+            return out;
+        }
+
+    } // namespace metrics
+} // namespace eventcore
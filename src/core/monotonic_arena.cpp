@@ -0,0 +1,109 @@
+#include "eventcore/core/monotonic_arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace eventcore {
+
+    constexpr size_t MonotonicArena::kDefaultBlockSize;
+    constexpr size_t MonotonicArena::kMaxBlockSize;
+
+    MonotonicArena::MonotonicArena(size_t block_size)
+        : block_size_(std::max<size_t>(block_size, 64)) {}
+
+    MonotonicArena::~MonotonicArena() {
+        release_all();
+    }
+
+    MonotonicArena::MonotonicArena(MonotonicArena&& other) noexcept
+        : NonCopyable(),
+        block_size_(other.block_size_),
+        head_(other.head_),
+        cursor_(other.cursor_),
+        limit_(other.limit_),
+        used_(other.used_),
+        reserved_(other.reserved_),
+        blocks_(other.blocks_) {
+            other.head_ = nullptr;
+            other.cursor_ = other.limit_ = nullptr;
+            other.used_ = other.reserved_ = other.blocks_ = 0;
+        }
+
+    MonotonicArena& MonotonicArena::operator=(MonotonicArena&& other) noexcept {
+        if (this != &other) {
+            release_all();
+            block_size_ = other.block_size_;
+            head_ = other.head_;
+            cursor_ = other.cursor_;
+            limit_ = other.limit_;
+            used_ = other.used_;
+            reserved_ = other.reserved_;
+            blocks_ = other.blocks_;
+            other.head_ = nullptr;
+            other.cursor_ = other.limit_ = nullptr;
+            other.used_ = other.reserved_ = other.blocks_ = 0;
+        }
+        return *this;
+    }
+
+    void* MonotonicArena::allocate(size_t size, size_t align) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor_) + align - 1) & ~(align - 1);
+        if (cursor_ == nullptr || p + size > reinterpret_cast<uintptr_t>(limit_)) {
+            grow(size, align);
+            p = (reinterpret_cast<uintptr_t>(cursor_) + align - 1) & ~(align - 1);
+        }
+        char* result = reinterpret_cast<char*>(p);
+        cursor_ = result + size;
+        used_ += size;
+        return result;
+    }
+
+    char* MonotonicArena::copy(const char* data, size_t size) {
+        char* dst = static_cast<char*>(allocate(size, 1));
+        if (size > 0) std::memcpy(dst, data, size);
+        return dst;
+    }
+
+    void MonotonicArena::reset() {
+        if (head_ == nullptr) return;
+        // Older blocks are smaller than the head, so keeping only the head
+        // holds on to the capacity the workload turned out to need.
+        Block* block = head_->next;
+        while (block != nullptr) {
+            Block* next = block->next;
+            reserved_ -= block->size;
+            --blocks_;
+            ::operator delete(block);
+            block = next;
+        }
+        head_->next = nullptr;
+        cursor_ = head_->data();
+        limit_ = cursor_ + head_->size;
+        used_ = 0;
+    }
+
+    void MonotonicArena::grow(size_t min_size, size_t align) {
+        size_t size = head_ ? std::min(head_->size * 2, kMaxBlockSize) : block_size_;
+        size = std::max(size, min_size + align);
+        Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+        block->next = head_;
+        block->size = size;
+        head_ = block;
+        cursor_ = block->data();
+        limit_ = cursor_ + size;
+        reserved_ += size;
+        ++blocks_;
+    }
+
+    void MonotonicArena::release_all() {
+        while (head_ != nullptr) {
+            Block* next = head_->next;
+            ::operator delete(head_);
+            head_ = next;
+        }
+        cursor_ = limit_ = nullptr;
+        used_ = reserved_ = blocks_ = 0;
+    }
+
+} // namespace eventcore
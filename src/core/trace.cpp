@@ -0,0 +1,216 @@
+#include "eventcore/core/trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+namespace eventcore {
+    namespace trace {
+
+        namespace {
+
+            const char kMagic[8] = {'E', 'C', 'T', 'R', 'A', 'C', 'E', '1'};
+            constexpr uint32_t kVersion = 1;
+            constexpr size_t kHeaderSize = 24;
+
+            // Name of the value carried in Event::arg, or null if it carries none
+            const char* arg_name(EventType type) {
+                switch (type) {
+                    case EventType::kAccept: return "fd";
+                    case EventType::kFirstByte: return "bytes";
+                    case EventType::kParseDone: return "body_bytes";
+                    case EventType::kHandlerEnd: return "status";
+                    case EventType::kWriteComplete: return "bytes";
+                    default: return nullptr;
+                }
+            }
+
+            size_t round_up_pow2(size_t n) {
+                size_t size = 1;
+                while (size < n) size <<= 1;
+                return size;
+            }
+
+        } // namespace
+
+        const char* event_name(EventType type) {
+            switch (type) {
+                case EventType::kAccept: return "accept";
+                case EventType::kFirstByte: return "first_byte";
+                case EventType::kParseDone: return "parse_done";
+                case EventType::kHandlerStart:
+                case EventType::kHandlerEnd: return "handler";
+                case EventType::kWriteComplete: return "write_complete";
+                case EventType::kClose: return "close";
+            }
+            return "unknown";
+        }
+
+        uint64_t now_ns() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        FlightRecorder::FlightRecorder(uint16_t worker, size_t capacity)
+            : worker_(worker),
+            mask_(round_up_pow2(std::max<size_t>(capacity, 2)) - 1),
+            slots_(new Slot[mask_ + 1]) {
+            }
+
+        void FlightRecorder::record_at(uint64_t timestamp_ns, EventType type, uint64_t connection, uint32_t arg) {
+            const uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots_[index & mask_];
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+            slot.connection.store(connection, std::memory_order_relaxed);
+            slot.packed.store(arg | static_cast<uint64_t>(type) << 32, std::memory_order_relaxed);
+            slot.sequence.store(2 * (index + 1), std::memory_order_release);
+        }
+
+        std::vector<Event> FlightRecorder::snapshot() const {
+            std::vector<std::pair<uint64_t, Event>> found;
+            found.reserve(mask_ + 1);
+            for (size_t i = 0; i <= mask_; ++i) {
+                const Slot& slot = slots_[i];
+                const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence == 0 || (sequence & 1) != 0) continue;
+
+                Event event;
+                event.timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+                event.connection = slot.connection.load(std::memory_order_relaxed);
+                const uint64_t packed = slot.packed.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+                event.arg = static_cast<uint32_t>(packed);
+                event.worker = worker_;
+                event.type = static_cast<EventType>(packed >> 32);
+                event.reserved = 0;
+                found.emplace_back(sequence, event);
+            }
+
+            std::sort(found.begin(), found.end(),
+                    [](const std::pair<uint64_t, Event>& a, const std::pair<uint64_t, Event>& b) {
+                    return a.first < b.first;
+                    });
+            std::vector<Event> events;
+            events.reserve(found.size());
+            for (const auto& entry : found) events.push_back(entry.second);
+            return events;
+        }
+
+        std::string serialize(const std::vector<Event>& events) {
+            std::string out(kHeaderSize + events.size() * sizeof(Event), '\0');
+            const uint32_t event_size = sizeof(Event);
+            const uint64_t count = events.size();
+            std::memcpy(&out[0], kMagic, sizeof(kMagic));
+            std::memcpy(&out[8], &kVersion, sizeof(kVersion));
+            std::memcpy(&out[12], &event_size, sizeof(event_size));
+            std::memcpy(&out[16], &count, sizeof(count));
+            if (!events.empty()) std::memcpy(&out[kHeaderSize], events.data(), events.size() * sizeof(Event));
+            return out;
+        }
+
+        Result<std::vector<Event>> deserialize(const std::string& data) {
+            if (data.size() < kHeaderSize || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+                return Result<std::vector<Event>>::Err("Not an EventCore trace dump");
+            }
+            uint32_t version;
+            uint32_t event_size;
+            uint64_t count;
+            std::memcpy(&version, &data[8], sizeof(version));
+            std::memcpy(&event_size, &data[12], sizeof(event_size));
+            std::memcpy(&count, &data[16], sizeof(count));
+            if (version != kVersion || event_size != sizeof(Event)) {
+                return Result<std::vector<Event>>::Err("Unsupported trace dump version " + std::to_string(version));
+            }
+            if (count != (data.size() - kHeaderSize) / sizeof(Event) ||
+                    (data.size() - kHeaderSize) % sizeof(Event) != 0) {
+                return Result<std::vector<Event>>::Err("Truncated trace dump");
+            }
+
+            std::vector<Event> events(count);
+            if (count > 0) std::memcpy(events.data(), &data[kHeaderSize], events.size() * sizeof(Event));
+            return Result<std::vector<Event>>::Ok(std::move(events));
+        }
+
+        Result<void> write_file(const std::string& path, const std::vector<Event>& events) {
+            const std::string data = serialize(events);
+            // Written under a temporary name so a reader never sees half a dump
+            const std::string tmp = path + ".tmp";
+            FILE* file = std::fopen(tmp.c_str(), "wb");
+            if (!file) return Result<void>::Err(Error::from_errno(errno, "fopen"));
+            const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+            const int saved_errno = errno;
+            if (std::fclose(file) != 0 || !written) {
+                std::remove(tmp.c_str());
+                return Result<void>::Err(Error::from_errno(written ? errno : saved_errno, "fwrite"));
+            }
+            if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+                const int rename_errno = errno;
+                std::remove(tmp.c_str());
+                return Result<void>::Err(Error::from_errno(rename_errno, "rename"));
+            }
+            return Result<void>::Ok();
+        }
+
+        Result<std::vector<Event>> read_file(const std::string& path) {
+            FILE* file = std::fopen(path.c_str(), "rb");
+            if (!file) return Result<std::vector<Event>>::Err(Error::from_errno(errno, "fopen"));
+            std::string data;
+            char buf[65536];
+            size_t n;
+            while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) data.append(buf, n);
+            const bool failed = std::ferror(file) != 0;
+            std::fclose(file);
+            if (failed) return Result<std::vector<Event>>::Err("Failed to read " + path);
+            return deserialize(data);
+        }
+
+        std::string to_chrome_json(const std::vector<Event>& events) {
+            uint64_t origin = UINT64_MAX;
+            std::set<uint16_t> workers;
+            for (const auto& event : events) {
+                origin = std::min(origin, event.timestamp_ns);
+                workers.insert(event.worker);
+            }
+
+            std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+            char buf[256];
+            bool first = true;
+            for (uint16_t worker : workers) {
+                std::snprintf(buf, sizeof(buf),
+                        "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"worker %u\"}}",
+                        first ? "" : ",", static_cast<unsigned>(worker), static_cast<unsigned>(worker));
+                out += buf;
+                first = false;
+            }
+
+            for (const auto& event : events) {
+                const char* phase = event.type == EventType::kHandlerStart ? "B"
+                    : event.type == EventType::kHandlerEnd ? "E" : "i";
+                const uint64_t offset = event.timestamp_ns - origin;
+                int n = std::snprintf(buf, sizeof(buf),
+                        "%s\n{\"name\":\"%s\",\"ph\":\"%s\",%s\"pid\":%u,\"tid\":%" PRIu64
+                        ",\"ts\":%" PRIu64 ".%03u",
+                        first ? "" : ",", event_name(event.type), phase, phase[0] == 'i' ? "\"s\":\"t\"," : "",
+                        static_cast<unsigned>(event.worker), event.connection,
+                        offset / 1000, static_cast<unsigned>(offset % 1000));
+                out.append(buf, static_cast<size_t>(n));
+                if (const char* name = arg_name(event.type)) {
+                    n = std::snprintf(buf, sizeof(buf), ",\"args\":{\"%s\":%u}", name, event.arg);
+                    out.append(buf, static_cast<size_t>(n));
+                }
+                out += '}';
+                first = false;
+            }
+            out += "\n]}\n";
+            return out;
+        }
+
+    } // namespace trace
+} // namespace eventcore
@@ -1,54 +1,59 @@
 #include "eventcore/http/connection.h"
 #include "eventcore/core/logger.h"
+#include <cerrno>
 #include <unistd.h>
 #include <sstream>
 
 namespace eventcore {
     namespace http {
 
+        constexpr size_t Connection::kOutputHighWaterMark;
+        constexpr std::chrono::seconds Connection::kLingerTime;
+
+        // The socket is expected to be non-blocking already (Socket::accept applies
+        // SOCK_NONBLOCK), so no fcntl round trips are made here.
         Connection::Connection(net::Socket socket, RequestHandler handler)
-            : socket_(std::move(socket)),
+            : last_activity_(std::chrono::steady_clock::now().time_since_epoch().count()),
+            socket_(std::move(socket)),
             state_(kConnecting),
             request_handler_(handler) 
         {
-            auto result = socket_.set_nonblocking(true);
-            if (result.is_err()) {
-                std::stringstream ss;
-                ss << "Failed to set socket non-blocking: " << result.error();
-                LOG_ERROR(ss.str());
-            }
         }
 
         Connection::~Connection() {
-            if (state_ != kDisconnected) {
-                force_close();
-            }
+            // shared_from_this() is unusable here, so the close callback is skipped.
+            state_ = kDisconnected;
+            socket_.close();
         }
 
         void Connection::start() {
             state_ = kConnected;
             update_activity();  // Initialize activity timer
-            handle_read();
+            // Input that arrived before registration is reported by the poller,
+            // so the first read is driven by readiness like every other one.
         }
 
         void Connection::send(const Response& response) {
             if (state_ != kConnected) return;
-            std::string response_str = response.to_string();
-            write_buffer_.append(response_str.data(), response_str.size());
+            response.serialize(&write_buffer_);
             handle_write();
         }
 
         void Connection::shutdown() {
             if (state_ == kConnected) {
                 state_ = kDisconnecting;
-                socket_.shutdown_write();
+                // Queued responses go out first; handle_write() closes once they have
+                if (write_buffer_.readable_bytes() == 0) socket_.shutdown_write();
             }
         }
 
         void Connection::force_close() {
             if (state_ != kDisconnected) {
                 state_ = kDisconnected;
-                socket_.close();
+                if (!deferred_close_) socket_.close();
+                read_buffer_.clear();
+                write_buffer_.clear();
+                if (trace_) trace_->record(trace::EventType::kClose, trace_id_);
                 if (close_callback_) {
                     close_callback_(shared_from_this());
                 }
@@ -56,39 +61,77 @@ namespace eventcore {
         }
 
         void Connection::handle_read() {
+            if (state_ == kLingering) {
+                discard_input();
+                return;
+            }
             if (state_ != kConnected) return;
 
-            // Edge-triggered: read until EAGAIN
-            while (true) {
+            // Edge-triggered: read until EAGAIN, until a request closed us, or
+            // until the peer stops draining its responses
+            while (state_ == kConnected && !output_backlogged()) {
+                // Requests buffered when the backlog paused parsing come first; the
+                // socket may hold nothing more to signal readiness for them.
+                if (parse_paused_) {
+                    parse_paused_ = false;
+                    process_request();
+                    continue;
+                }
+
                 ssize_t n = read_buffer_.read_from_fd(socket_.fd());
 
                 if (n > 0) {
                     update_activity();
+                    if (metrics_) metrics_->bytes_received->inc(static_cast<uint64_t>(n));
                     process_request();
                 } else if (n == 0) {
                     handle_close();
                     break;
                 } else {
                     if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        // Waiting for the next request: hand idle slabs back to the pool
+                        read_buffer_.shrink();
                         break;  // No more data available
                     }
                     handle_error();
                     break;
                 }
             }
+            // A request rejected during this read leaves the rest of the input unread
+            if (state_ == kLingering) discard_input();
         }
 
         void Connection::handle_write() {
-            if (state_ != kConnected && state_ != kDisconnecting) return;
+            if (state_ != kConnected && state_ != kDisconnecting && state_ != kLingering) return;
 
             if (write_buffer_.readable_bytes() > 0) {
-                auto result = socket_.send(write_buffer_.peek(), write_buffer_.readable_bytes());
+                struct iovec iov[net::Buffer::kMaxIovecs];
+                size_t count = write_buffer_.peek_iovec(iov, net::Buffer::kMaxIovecs);
+                std::chrono::steady_clock::time_point start;
+                if (metrics_) start = std::chrono::steady_clock::now();
+                auto result = socket_.sendv(iov, count);
+                if (metrics_) {
+                    metrics_->write_latency->record(static_cast<uint64_t>(
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - start).count()));
+                }
                 if (result.is_ok()) {
                     write_buffer_.retrieve(result.value());
-                    if (write_buffer_.readable_bytes() == 0 && state_ == kDisconnecting) {
-                        force_close();
+                    if (metrics_) metrics_->bytes_sent->inc(result.value());
+                    if (write_buffer_.readable_bytes() == 0) {
+                        if (trace_) {
+                            trace_->record(trace::EventType::kWriteComplete, trace_id_,
+                                    trace::saturate(result.value()));
+                        }
+                        write_buffer_.shrink();
+                        if (state_ == kDisconnecting) {
+                            force_close();
+                        } else if (state_ == kLingering) {
+                            // EOF follows the error response; input is still drained
+                            socket_.shutdown_write();
+                        }
                     }
-                } else {
+                } else if (!result.would_block()) {
                     handle_error();
                 }
             } else if (state_ == kDisconnecting) {
@@ -111,79 +154,184 @@ namespace eventcore {
         }
 
         void Connection::process_request() {
-            while (true) {
-                Request request;
-                parser_.reset();
-
+            // request_ and parser_ carry a partially received request over to the
+            // next read; both are reset only once a response has been queued.
+            // Pipelined requests are answered strictly in order, since only one
+            // task at a time runs a connection's reads. Parsing pauses at the
+            // output high-water mark, so one read of many pipelined requests
+            // cannot queue an unbounded amount of output.
+            while (state_ == kConnected) {
+                if (output_backlogged()) {
+                    parse_paused_ = read_buffer_.readable_bytes() > 0;
+                    break;
+                }
                 LOG_DEBUG("Attempting to parse request, readable bytes: ",
                         read_buffer_.readable_bytes());
+                if (trace_ && !request_started_ && read_buffer_.readable_bytes() > 0) {
+                    trace_->record(trace::EventType::kFirstByte, trace_id_,
+                            trace::saturate(read_buffer_.readable_bytes()));
+                    request_started_ = true;
+                }
 
-                if (!parser_.parse_request(&read_buffer_, &request)) {
-                    LOG_DEBUG("Parse failed or incomplete");
+                bool parsed;
+                if (metrics_) {
+                    const auto start = std::chrono::steady_clock::now();
+                    parsed = parser_.parse_request(&read_buffer_, &request_);
+                    parse_ns_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - start).count());
+                } else {
+                    parsed = parser_.parse_request(&read_buffer_, &request_);
+                }
+
+                if (!parsed) {
+                    if (parser_.has_error()) {
+                        reject_request(parser_.error_status());
+                    } else {
+                        LOG_DEBUG("Request incomplete, waiting for more data");
+                    }
                     break;
                 }
 
-                if (parser_.is_complete()) {
-                    LOG_DEBUG("Request parsed successfully: ",
-                            Request::method_to_string(request.method()), " ",
-                            request.path());
+                LOG_DEBUG("Request parsed successfully: ",
+                        Request::method_to_string(request_.method()), " ",
+                        request_.path());
+                if (trace_) {
+                    trace_->record(trace::EventType::kParseDone, trace_id_, trace::saturate(request_.body().size()));
+                    trace_->record(trace::EventType::kHandlerStart, trace_id_);
+                }
+
+                Response response;
+                if (metrics_) {
+                    metrics_->parse_latency->record(parse_ns_);
+                    parse_ns_ = 0;
+                    response = request_handler_(request_);
+                    metrics_->requests->inc();
+                } else {
+                    response = request_handler_(request_);
+                }
+                if (trace_) {
+                    trace_->record(trace::EventType::kHandlerEnd, trace_id_,
+                            static_cast<uint32_t>(response.status_code()));
+                }
 
-                    request_ = request;
-                    Response response = request_handler_(request);
+                LOG_DEBUG("Queueing response with status: ", response.status_code());
+                queue_response(response);
 
-                    LOG_DEBUG("Sending response with status: ", response.status_code());
-                    send_response(response);
+                const HeaderList::Field* connection = request_.header(HeaderId::kConnection);
+                const bool close = connection != nullptr && connection->value_equals("close", 5);
 
-                    std::string connection = request.get_header("Connection");
-                    LOG_DEBUG("Connection header: ", connection);
+                // The response has been serialized into the write buffer, so the
+                // request's header arena can be recycled in one go.
+                request_.reset();
+                parser_.reset();
+                request_started_ = false;
 
-                    if (connection == "close") {
-                        LOG_DEBUG("Closing connection as requested");
-                        shutdown();
-                        break;
-                    }
-                } else {
-                    LOG_DEBUG("Parser not complete yet");
+                if (close) {
+                    LOG_DEBUG("Closing connection as requested");
+                    shutdown();
                     break;
                 }
             }
+
+            // Every response produced from this read goes out in one writev
+            handle_write();
         }
 
-        void Connection::send_response(const Response& response) {
-            std::string request_connection = request_.get_header("Connection");
+        void Connection::queue_response(Response& response) {
+            const HeaderList::Field* connection = request_.header(HeaderId::kConnection);
             bool keep_alive =
-                request_connection == "keep-alive" ||
+                (connection != nullptr && connection->value_equals("keep-alive", 10)) ||
                 (request_.version() == Version::HTTP_1_1 &&
-                 request_connection != "close");
+                 (connection == nullptr || !connection->value_equals("close", 5)));
 
-            Response resp = response;
-            resp.set_keep_alive(keep_alive);
-            send(resp);
+            response.set_keep_alive(keep_alive);
+            response.serialize(&write_buffer_);
         }
 
-        void Connection::reset(int fd) {
-            socket_ = net::Socket(fd);
+        void Connection::reject_request(int status) {
+            LOG_DEBUG("Rejecting malformed request on fd ", socket_.fd(), " with status ", status);
+            if (metrics_) metrics_->rejected_requests->inc();
+            Response response;
+            response.set_status(status);
+            response.set_content_type("text/plain");
+            response.set_body(response.status_message());
+            response.set_keep_alive(false);
+            response.serialize(&write_buffer_);
+            // Whatever follows the bad request cannot be framed, so it is dropped.
+            // The client may still be sending it, so the socket lingers instead of
+            // closing on unread data.
+            read_buffer_.clear();
+            linger_deadline_.store((std::chrono::steady_clock::now() + kLingerTime).time_since_epoch().count(),
+                    std::memory_order_relaxed);
+            state_ = kLingering;
+        }
 
-            auto result = socket_.set_nonblocking(true);
-            if (result.is_err()) {
-                LOG_ERROR("Failed to set non-blocking: ", result.error());
+        void Connection::discard_input() {
+            char sink[16 * 1024];
+            while (state_ == kLingering) {
+                std::chrono::steady_clock::time_point deadline(
+                        std::chrono::steady_clock::duration(linger_deadline_.load(std::memory_order_relaxed)));
+                if (std::chrono::steady_clock::now() > deadline) {
+                    force_close();
+                    return;
+                }
+                ssize_t n = ::read(socket_.fd(), sink, sizeof(sink));
+                if (n > 0) {
+                    if (metrics_) metrics_->bytes_received->inc(static_cast<uint64_t>(n));
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+                if (n == 0 && write_buffer_.readable_bytes() > 0) {
+                    // The peer finished sending but may still be reading the response
+                    state_ = kDisconnecting;
+                    return;
+                }
+                force_close();
+                return;
             }
+        }
+
+        void Connection::set_parser_limits(const ParserLimits& limits) {
+            parser_.set_limits(limits);
+        }
 
+        void Connection::reset(int fd) {
+            socket_ = net::Socket(fd);
             state_ = kConnecting;
-            read_buffer_.retrieve_all();
-            write_buffer_.retrieve_all();
+            deferred_close_ = false;
+            read_buffer_.clear();
+            write_buffer_.clear();
             parser_.reset();
             request_.reset();
-            last_activity_ = std::chrono::steady_clock::now();
+            parse_ns_ = 0;
+            trace_ = nullptr;
+            request_started_ = false;
+            parse_paused_ = false;
+            linger_deadline_.store(0, std::memory_order_relaxed);
+            update_activity();
+        }
+
+        void Connection::set_buffer_pool(net::SlabPool* pool) {
+            read_buffer_.set_pool(pool);
+            write_buffer_.set_pool(pool);
         }
 
         void Connection::update_activity() {
-            last_activity_ = std::chrono::steady_clock::now();
+            last_activity_.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                    std::memory_order_relaxed);
         }
 
         bool Connection::is_idle(std::chrono::seconds timeout) const {
-            auto now = std::chrono::steady_clock::now();
-            return (now - last_activity_) > timeout;
+            // A lingering connection whose peer went quiet is closed by the idle scan
+            if (state_ == kLingering) {
+                std::chrono::steady_clock::time_point deadline(
+                        std::chrono::steady_clock::duration(linger_deadline_.load(std::memory_order_relaxed)));
+                if (std::chrono::steady_clock::now() > deadline) return true;
+            }
+            std::chrono::steady_clock::time_point last(
+                    std::chrono::steady_clock::duration(last_activity_.load(std::memory_order_relaxed)));
+            return (std::chrono::steady_clock::now() - last) > timeout;
         }
 
     }  // namespace http
@@ -0,0 +1,164 @@
+#include "eventcore/http/headers.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+namespace eventcore {
+    namespace http {
+
+        namespace {
+
+            // Spelled as they are sent; indexed by HeaderId.
+            const char* const kHeaderNames[kNumKnownHeaders] = {
+                "Host", "Connection", "Content-Length", "Content-Type", "Transfer-Encoding",
+                "Accept-Encoding", "Accept", "User-Agent", "Cookie", "Authorization",
+                "Cache-Control", "Content-Encoding", "Date", "Server", "Upgrade", "Expect",
+                "Keep-Alive", "If-None-Match", "Location", "Set-Cookie", "Accept-Language",
+                "Referer", "Origin", "Range", "Last-Modified", "ETag",
+            };
+
+            inline unsigned char lower(char c) {
+                unsigned char u = static_cast<unsigned char>(c);
+                return (u >= 'A' && u <= 'Z') ? static_cast<unsigned char>(u | 0x20) : u;
+            }
+
+            // Length, first and last letter are enough to tell the known names
+            // apart; the constants were searched for offline so that no two
+            // names share a bucket. The candidate is still compared in full.
+            constexpr size_t kHashBuckets = 64;
+
+            inline size_t header_hash(const char* name, size_t size) {
+                return (size * 11 + lower(name[0]) * 60u + lower(name[size - 1])) & (kHashBuckets - 1);
+            }
+
+            std::array<HeaderId, kHashBuckets> build_table() {
+                std::array<HeaderId, kHashBuckets> table;
+                table.fill(HeaderId::kUnknown);
+                for (size_t i = 0; i < kNumKnownHeaders; ++i) {
+                    size_t h = header_hash(kHeaderNames[i], std::strlen(kHeaderNames[i]));
+                    assert(table[h] == HeaderId::kUnknown && "header hash collision");
+                    table[h] = static_cast<HeaderId>(i);
+                }
+                return table;
+            }
+
+            const std::array<HeaderId, kHashBuckets> kHeaderTable = build_table();
+
+        } // namespace
+
+        bool equals_ignore_case(const char* a, size_t a_size, const char* b, size_t b_size) {
+            if (a_size != b_size) return false;
+            for (size_t i = 0; i < a_size; ++i) {
+                if (lower(a[i]) != lower(b[i])) return false;
+            }
+            return true;
+        }
+
+        HeaderId lookup_header(const char* name, size_t size) {
+            if (size == 0) return HeaderId::kUnknown;
+            HeaderId id = kHeaderTable[header_hash(name, size)];
+            if (id == HeaderId::kUnknown) return id;
+            const char* candidate = kHeaderNames[static_cast<size_t>(id)];
+            return equals_ignore_case(name, size, candidate, std::strlen(candidate)) ? id : HeaderId::kUnknown;
+        }
+
+        const char* header_name(HeaderId id) {
+            return id == HeaderId::kUnknown ? "" : kHeaderNames[static_cast<size_t>(id)];
+        }
+
+        constexpr uint16_t HeaderList::kNoField;
+
+        HeaderList::HeaderList() {
+            std::fill(std::begin(known_), std::end(known_), kNoField);
+        }
+
+        HeaderList::HeaderList(const HeaderList& other) : HeaderList() {
+            append_copy(other);
+        }
+
+        HeaderList& HeaderList::operator=(const HeaderList& other) {
+            if (this != &other) {
+                clear();
+                append_copy(other);
+            }
+            return *this;
+        }
+
+        HeaderList::HeaderList(HeaderList&& other) noexcept
+            : arena_(std::move(other.arena_)), fields_(std::move(other.fields_)) {
+                std::copy(std::begin(other.known_), std::end(other.known_), std::begin(known_));
+                other.fields_.clear();
+                std::fill(std::begin(other.known_), std::end(other.known_), kNoField);
+            }
+
+        HeaderList& HeaderList::operator=(HeaderList&& other) noexcept {
+            if (this != &other) {
+                arena_ = std::move(other.arena_);
+                fields_ = std::move(other.fields_);
+                std::copy(std::begin(other.known_), std::end(other.known_), std::begin(known_));
+                other.fields_.clear();
+                std::fill(std::begin(other.known_), std::end(other.known_), kNoField);
+            }
+            return *this;
+        }
+
+        const HeaderList::Field* HeaderList::find(HeaderId id) const {
+            if (id == HeaderId::kUnknown) return nullptr;
+            uint16_t index = known_[static_cast<size_t>(id)];
+            return index == kNoField ? nullptr : &fields_[index];
+        }
+
+        const HeaderList::Field* HeaderList::find(const char* name, size_t size) const {
+            return const_cast<HeaderList*>(this)->find_field(lookup_header(name, size), name, size);
+        }
+
+        HeaderList::Field* HeaderList::find_field(HeaderId id, const char* name, size_t size) {
+            if (id != HeaderId::kUnknown) {
+                uint16_t index = known_[static_cast<size_t>(id)];
+                return index == kNoField ? nullptr : &fields_[index];
+            }
+            for (Field& field : fields_) {
+                if (field.id == HeaderId::kUnknown &&
+                        equals_ignore_case(field.name, field.name_size, name, size)) return &field;
+            }
+            return nullptr;
+        }
+
+        HeaderId HeaderList::set(const char* name, size_t name_size, const char* value, size_t value_size) {
+            const HeaderId id = lookup_header(name, name_size);
+            Field* field = find_field(id, name, name_size);
+            if (field == nullptr) {
+                if (id != HeaderId::kUnknown) known_[static_cast<size_t>(id)] = static_cast<uint16_t>(fields_.size());
+                fields_.push_back(Field{arena_.copy(name, name_size), nullptr,
+                        static_cast<uint32_t>(name_size), 0, 0, id});
+                field = &fields_.back();
+            }
+            if (value_size > field->value_capacity) {
+                field->value = arena_.copy(value, value_size);
+                field->value_capacity = static_cast<uint32_t>(value_size);
+            } else if (value_size > 0) {
+                // Rewrites such as a growing Content-Length reuse the old bytes
+                std::memcpy(field->value, value, value_size);
+            }
+            field->value_size = static_cast<uint32_t>(value_size);
+            return id;
+        }
+
+        void HeaderList::clear() {
+            for (const Field& field : fields_) {
+                if (field.id != HeaderId::kUnknown) known_[static_cast<size_t>(field.id)] = kNoField;
+            }
+            fields_.clear();
+            arena_.reset();
+        }
+
+        void HeaderList::append_copy(const HeaderList& other) {
+            fields_.reserve(other.fields_.size());
+            for (const Field& field : other.fields_) {
+                set(field.name, field.name_size, field.value, field.value_size);
+            }
+        }
+
+    } // namespace http
+} // namespace eventcore
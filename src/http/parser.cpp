@@ -1,11 +1,29 @@
 #include "eventcore/http/parser.h"
-#include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <cstdint>
 
 namespace eventcore {
     namespace http {
 
-        Parser::Parser() : state_(kExpectRequestLine), request_(nullptr), content_length_(0) {}
+        namespace {
+
+            // RFC 9110 tchar, the characters a field name may contain
+            struct TokenTable {
+                bool allowed[256];
+                TokenTable() : allowed() {
+                    for (int c = '0'; c <= '9'; ++c) allowed[c] = true;
+                    for (int c = 'a'; c <= 'z'; ++c) allowed[c] = true;
+                    for (int c = 'A'; c <= 'Z'; ++c) allowed[c] = true;
+                    for (const char* p = "!#$%&'*+-.^_`|~"; *p; ++p) allowed[static_cast<unsigned char>(*p)] = true;
+                }
+            };
+            const TokenTable kTokenTable;
+
+        } // namespace
+
+        Parser::Parser(const ParserLimits& limits)
+            : state_(kExpectRequestLine), request_(nullptr), content_length_(0), limits_(limits) {}
 
         bool Parser::parse_request(net::Buffer* buffer, Request* request) {
             request_ = request;
@@ -14,19 +32,28 @@ namespace eventcore {
 
             while (has_more && state_ != kComplete) {
                 switch (state_) {
-                    case kExpectRequestLine:
-                        if (const char* crlf = buffer->find_crlf()) {
-                            ok = parse_request_line(buffer->peek(), crlf);
+                    case kExpectRequestLine: {
+                        const size_t eol = buffer->find_crlf();
+                        if (eol != net::Buffer::kNpos) {
+                            if (eol > limits_.max_request_line) {
+                                ok = fail(414);
+                                break;
+                            }
+                            const char* line = buffer->contiguous(eol);
+                            ok = parse_request_line(line, line + eol) || fail(400);
                             if (ok) {
-                                buffer->retrieve(crlf - buffer->peek() + 2);
+                                buffer->retrieve(eol + 2);
                                 state_ = kExpectHeaders;
                             } else {
                                 has_more = false;
                             }
                         } else {
+                            // One extra byte may be the CR of a line that is still in limits
+                            if (buffer->readable_bytes() > limits_.max_request_line + 1) ok = fail(414);
                             has_more = false;
                         }
                         break;
+                    }
 
                     case kExpectHeaders:
                         if (parse_headers(buffer)) {
@@ -37,6 +64,7 @@ namespace eventcore {
                                 has_more = false;
                             }
                         } else {
+                            ok = state_ != kError;
                             has_more = false;
                         }
                         break;
@@ -51,6 +79,8 @@ namespace eventcore {
                         break;
 
                     case kComplete:
+                    case kError:
+                        ok = state_ != kError;
                         has_more = false;
                         break;
                 }
@@ -85,36 +115,89 @@ namespace eventcore {
         //    return ok;
         //}
 
-        void Parser::reset() { state_ = kExpectRequestLine; request_ = nullptr; content_length_ = 0; }
+        void Parser::reset() {
+            state_ = kExpectRequestLine; request_ = nullptr; content_length_ = 0;
+            header_bytes_ = 0; header_count_ = 0; error_status_ = 0; has_content_length_ = false;
+        }
+
+        bool Parser::fail(int status) {
+            state_ = kError;
+            error_status_ = status;
+            return false;
+        }
 
         bool Parser::parse_request_line(const char* begin, const char* end) {
-            std::string line(begin, end); std::istringstream iss(line);
-            std::string method, path, version;
-            if (!(iss >> method >> path >> version)) return false;
-            request_->set_method(Request::string_to_method(method));
-            size_t query_pos = path.find('?');
-            if (query_pos != std::string::npos) {
-                request_->set_path(path.substr(0, query_pos));
-                request_->set_query(path.substr(query_pos + 1));
-            } else request_->set_path(path);
-            request_->set_version(Request::string_to_version(version));
+            // METHOD SP request-target SP HTTP-version, tolerating runs of spaces
+            const char* tokens[3][2];
+            const char* p = begin;
+            for (int i = 0; i < 3; ++i) {
+                while (p < end && isspace(static_cast<unsigned char>(*p))) ++p;
+                if (p == end) return false;
+                tokens[i][0] = p;
+                while (p < end && !isspace(static_cast<unsigned char>(*p))) ++p;
+                tokens[i][1] = p;
+            }
+            request_->set_method(Request::string_to_method(std::string(tokens[0][0], tokens[0][1])));
+            const char* path = tokens[1][0];
+            const char* path_end = tokens[1][1];
+            const char* query = std::find(path, path_end, '?');
+            request_->set_path(path, static_cast<size_t>(query - path));
+            if (query != path_end) {
+                request_->set_query(query + 1, static_cast<size_t>(path_end - query - 1));
+            }
+            request_->set_version(Request::string_to_version(std::string(tokens[2][0], tokens[2][1])));
             return request_->method() != Method::UNKNOWN && request_->version() != Version::UNKNOWN;
         }
 
         bool Parser::parse_headers(net::Buffer* buffer) {
-            while (const char* crlf = buffer->find_crlf()) {
-                const char* colon = std::find(buffer->peek(), crlf, ':');
-                if (colon != crlf) {
-                    std::string name(buffer->peek(), colon); ++colon;
-                    while (colon < crlf && isspace(*colon)) ++colon;
-                    std::string value(colon, crlf); request_->set_header(name, value);
-                    if (name == "Content-Length") content_length_ = std::stoul(value);
-                } else { buffer->retrieve(crlf - buffer->peek() + 2); return true; }
-                buffer->retrieve(crlf - buffer->peek() + 2);
+            size_t eol;
+            while ((eol = buffer->find_crlf()) != net::Buffer::kNpos) {
+                header_bytes_ += eol + 2;
+                if (header_bytes_ > limits_.max_header_bytes) return fail(431);
+                if (eol == 0) { buffer->retrieve(2); return true; }
+                if (++header_count_ > limits_.max_header_count) return fail(431);
+
+                const char* line = buffer->contiguous(eol);
+                const char* crlf = line + eol;
+                const char* colon = std::find(line, crlf, ':');
+                if (colon == crlf || colon == line) return fail(400);
+                // Includes whitespace before the colon, which RFC 9112 5.1 requires
+                // rejecting: "Content-Length : 5" must not be stored as another header
+                for (const char* p = line; p < colon; ++p) {
+                    if (!kTokenTable.allowed[static_cast<unsigned char>(*p)]) return fail(400);
+                }
+
+                const size_t name_size = static_cast<size_t>(colon - line); ++colon;
+                while (colon < crlf && isspace(static_cast<unsigned char>(*colon))) ++colon;
+                const size_t value_size = static_cast<size_t>(crlf - colon);
+                HeaderId id = request_->set_header(line, name_size, colon, value_size);
+                if (id == HeaderId::kContentLength && !parse_content_length(colon, crlf)) return false;
+                // Chunked bodies are not supported. Treating one as the next
+                // pipelined request would let it smuggle requests past a proxy.
+                if (id == HeaderId::kTransferEncoding) return fail(400);
+                buffer->retrieve(eol + 2);
             }
+            if (header_bytes_ + buffer->readable_bytes() > limits_.max_header_bytes + 1) return fail(431);
             return false;
         }
 
+        bool Parser::parse_content_length(const char* begin, const char* end) {
+            while (end > begin && isspace(static_cast<unsigned char>(end[-1]))) --end;
+            if (begin == end) return fail(400);
+            size_t length = 0;
+            for (const char* p = begin; p < end; ++p) {
+                if (*p < '0' || *p > '9') return fail(400);
+                if (length > (SIZE_MAX - 9) / 10) return fail(413);
+                length = length * 10 + static_cast<size_t>(*p - '0');
+                if (length > limits_.max_body_size) return fail(413);
+            }
+            // Repeats must agree, or the body could be framed two ways
+            if (has_content_length_ && length != content_length_) return fail(400);
+            content_length_ = length;
+            has_content_length_ = true;
+            return true;
+        }
+
         bool Parser::parse_body(net::Buffer* buffer) {
             if (buffer->readable_bytes() >= content_length_) {
                 request_->set_body(buffer->retrieve_as_string(content_length_)); return true;
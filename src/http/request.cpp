@@ -7,16 +7,16 @@ namespace eventcore {
     namespace http {
 
         std::string Request::get_header(const std::string& name) const {
-            auto it = headers_.find(name);
-            return it != headers_.end() ? it->second : "";
+            const HeaderList::Field* field = headers_.find(name);
+            return field ? field->value_string() : std::string();
         }
 
         bool Request::has_header(const std::string& name) const {
-            return headers_.find(name) != headers_.end();
+            return headers_.find(name) != nullptr;
         }
 
         void Request::set_header(const std::string& name, const std::string& value) {
-            headers_[name] = value;
+            headers_.set(name, value);
         }
 
         void Request::reset() {
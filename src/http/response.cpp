@@ -1,5 +1,5 @@
 #include "eventcore/http/response.h"
-#include <sstream>
+#include <cstdio>
 
 namespace eventcore {
     namespace http {
@@ -12,7 +12,7 @@ namespace eventcore {
         }
 
         void Response::set_header(const std::string& name, const std::string& value) {
-            headers_[name] = value;
+            headers_.set(name, value);
         }
 
         void Response::set_body(const std::string& body) {
@@ -34,18 +34,40 @@ namespace eventcore {
             set_header("Connection", keep_alive ? "keep-alive" : "close");
         }
 
-        std::string Response::to_string() const {
-            std::stringstream ss;
-            ss << "HTTP/1.1 " << status_code_ << " " << status_message_ << "\r\n";
-            for (const auto& header : headers_) ss << header.first << ": " << header.second << "\r\n";
-            if (headers_.find("Connection") == headers_.end()) {
-                ss << "Connection: " << (keep_alive_ ? "keep-alive" : "close") << "\r\n";
+        template <typename Output>
+        void Response::write_to(Output& out) const {
+            char line[32];
+            int n = std::snprintf(line, sizeof(line), "HTTP/1.1 %d ", status_code_);
+            out.append(line, static_cast<size_t>(n));
+            out.append(status_message_.data(), status_message_.size());
+            out.append("\r\n", 2);
+            for (const auto& header : headers_) {
+                out.append(header.name, header.name_size);
+                out.append(": ", 2);
+                out.append(header.value, header.value_size);
+                out.append("\r\n", 2);
+            }
+            if (headers_.find(HeaderId::kConnection) == nullptr) {
+                if (keep_alive_) out.append("Connection: keep-alive\r\n", 24);
+                else out.append("Connection: close\r\n", 19);
             }
-            if (headers_.find("Content-Length") == headers_.end() && !body_.empty()) {
-                ss << "Content-Length: " << body_.size() << "\r\n";
+            if (headers_.find(HeaderId::kContentLength) == nullptr && !body_.empty()) {
+                n = std::snprintf(line, sizeof(line), "Content-Length: %zu\r\n", body_.size());
+                out.append(line, static_cast<size_t>(n));
             }
-            ss << "\r\n" << body_;
-            return ss.str();
+            out.append("\r\n", 2);
+            out.append(body_.data(), body_.size());
+        }
+
+        std::string Response::to_string() const {
+            std::string out;
+            out.reserve(128 + body_.size());
+            write_to(out);
+            return out;
+        }
+
+        void Response::serialize(net::Buffer* out) const {
+            write_to(*out);
         }
 
         Response Response::make_404() {
@@ -74,6 +96,8 @@ namespace eventcore {
                 case 301: return "Moved Permanently"; case 302: return "Found"; case 304: return "Not Modified";
                 case 400: return "Bad Request"; case 401: return "Unauthorized"; case 403: return "Forbidden";
                 case 404: return "Not Found"; case 405: return "Method Not Allowed";
+                case 413: return "Payload Too Large"; case 414: return "URI Too Long";
+                case 431: return "Request Header Fields Too Large";
                 case 500: return "Internal Server Error"; case 502: return "Bad Gateway"; case 503: return "Service Unavailable";
                 default: return "Unknown";
             }
@@ -32,6 +32,8 @@ namespace eventcore {
             }
 
             route.handler = handler;
+            route.id = patterns_.size();
+            patterns_.push_back(pattern);
             routes_[method].push_back(route);
         }
 
@@ -51,6 +53,13 @@ namespace eventcore {
             add_route(Method::DELETE, pattern, handler);
         }
 
+        bool Router::has_route(Method method, const std::string& pattern) const {
+            auto method_routes = routes_.find(method);
+            if (method_routes == routes_.end()) return false;
+            return std::any_of(method_routes->second.begin(), method_routes->second.end(),
+                    [&pattern](const Route& route) { return route.pattern == pattern; });
+        }
+
         void Router::use(Middleware middleware) {
             use("", middleware);
         }
@@ -67,9 +76,18 @@ namespace eventcore {
             error_handler_ = handler;
         }
 
+        constexpr size_t Router::kNoRoute;
+
         Response Router::route(const Request& request) const {
+            return route(request, nullptr);
+        }
+
+        Response Router::route(const Request& request, size_t* route_id) const {
+            if (route_id) *route_id = kNoRoute;
             try {
-                Request modified_request = request;
+                // The request is only copied when a middleware may modify it
+                Request modified_request;
+                const Request* effective = &request;
                 Response response;
 
                 // Apply middlewares
@@ -78,6 +96,10 @@ namespace eventcore {
                     const Middleware& middleware = middleware_pair.second;
 
                     if (prefix.empty() || request.path().find(prefix) == 0) {
+                        if (effective == &request) {
+                            modified_request = request;
+                            effective = &modified_request;
+                        }
                         middleware(modified_request, response);
                     }
                 }
@@ -86,17 +108,21 @@ namespace eventcore {
                 if (method_routes != routes_.end()) {
                     for (const auto& route : method_routes->second) {
                         if (route.is_regex) {
-                            if (std::regex_match(request.path(), route.regex))
-                                return route.handler(modified_request);
+                            if (std::regex_match(request.path(), route.regex)) {
+                                if (route_id) *route_id = route.id;
+                                return route.handler(*effective);
+                            }
                         } else {
-                            if (route.pattern == request.path())
-                                return route.handler(modified_request);
+                            if (route.pattern == request.path()) {
+                                if (route_id) *route_id = route.id;
+                                return route.handler(*effective);
+                            }
                         }
                     }
                 }
 
                 if (not_found_handler_)
-                    return not_found_handler_(modified_request);
+                    return not_found_handler_(*effective);
 
                 return default_404();
 
@@ -112,6 +112,10 @@ eventcore::server::Config parse_command_line(int argc, char* argv[]) {
 int main(int argc, char* argv[]) {
     // Parse command line arguments first
     eventcore::server::Config config = parse_command_line(argc, argv);
+    // `kill -USR2 <pid>` writes the flight recorder; see eventcore_trace2json
+    config.trace_dump_signal = SIGUSR2;
+    config.trace_path = "/debug/trace";
+    config.metrics_path = "/metrics";
 
     // Initialize logger
     eventcore::logging::LogConfig log_config;
@@ -225,9 +229,10 @@ int main(int argc, char* argv[]) {
                 return resp;
                 });
 
-        server.router().get("/api/status", [](const eventcore::http::Request& req) {
+        server.router().get("/api/status", [&server](const eventcore::http::Request& req) {
                 eventcore::http::Response resp = eventcore::http::Response::make_json(200,
-                        R"({"status": "running", "server": "EventCore", "version": "1.0.0", "timestamp": )" + 
+                        R"({"status": "running", "server": "EventCore", "version": "1.0.0", "active_connections": )" +
+                        std::to_string(server.active_connections()) + R"(, "timestamp": )" +
                         std::to_string(std::time(nullptr)) + "}");
                 return resp;
                 });
@@ -254,6 +259,8 @@ int main(int argc, char* argv[]) {
         LOG_INFO("  GET  http://localhost:", config.port, "/api/time");
         LOG_INFO("  POST http://localhost:", config.port, "/api/echo");
         LOG_INFO("  GET  http://localhost:", config.port, "/api/status");
+        LOG_INFO("  GET  http://localhost:", config.port, config.metrics_path, " (Prometheus)");
+        LOG_INFO("  GET  http://localhost:", config.port, config.trace_path, "?format=json (flight recorder)");
 
         // Main event loop
         while (running) {
@@ -1,33 +1,137 @@
 #include "eventcore/net/address.h"
 #include <arpa/inet.h>
+#include <cstddef>
 #include <cstring>
 #include <sstream>
 
 namespace eventcore {
     namespace net {
 
-        Address::Address(const std::string& ip, uint16_t port) {
+        Address::Address() : len_(sizeof(struct sockaddr_in)) {
             std::memset(&addr_, 0, sizeof(addr_));
-            addr_.sin_family = AF_INET;
-            addr_.sin_port = htons(port);
-            inet_pton(AF_INET, ip.c_str(), &addr_.sin_addr);
+            addr_.ss_family = AF_INET;
         }
 
-        Address::Address(const struct sockaddr_in& addr) : addr_(addr) {}
+        Address::Address(const std::string& ip, uint16_t port) : Address() {
+            if (ip.find(':') != std::string::npos) {
+                auto* addr6 = reinterpret_cast<struct sockaddr_in6*>(&addr_);
+                addr6->sin6_family = AF_INET6;
+                addr6->sin6_port = htons(port);
+                inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr);
+                len_ = sizeof(struct sockaddr_in6);
+            } else {
+                auto* addr4 = reinterpret_cast<struct sockaddr_in*>(&addr_);
+                addr4->sin_family = AF_INET;
+                addr4->sin_port = htons(port);
+                inet_pton(AF_INET, ip.c_str(), &addr4->sin_addr);
+                len_ = sizeof(struct sockaddr_in);
+            }
+        }
+
+        Address::Address(const struct sockaddr_in& addr)
+            : Address(reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) {}
+
+        Address::Address(const struct sockaddr_in6& addr)
+            : Address(reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) {}
+
+        Address::Address(const struct sockaddr* addr, socklen_t len) : Address() {
+            if (len > sizeof(addr_)) len = sizeof(addr_);
+            std::memcpy(&addr_, addr, len);
+            len_ = len;
+        }
+
+        Result<Address> Address::unix_path(const std::string& path) {
+            Address result;
+            auto* un = reinterpret_cast<struct sockaddr_un*>(&result.addr_);
+            std::memset(un, 0, sizeof(*un));
+            un->sun_family = AF_UNIX;
+
+            if (path.size() > sizeof(un->sun_path) - 1) {
+                return Result<Address>::Err("unix socket path longer than " +
+                        std::to_string(sizeof(un->sun_path) - 1) + " bytes: " + path);
+            }
+            const size_t n = path.size();
+            std::memcpy(un->sun_path, path.data(), n);
+            if (n > 0 && path[0] == '@') {
+                un->sun_path[0] = '\0';  // Abstract namespace
+                result.len_ = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + n);
+            } else {
+                result.len_ = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + n + 1);
+            }
+            return Result<Address>::Ok(result);
+        }
+
+        Result<Address> Address::parse(const std::string& spec) {
+            if (spec.compare(0, 5, "unix:") == 0) {
+                if (spec.size() == 5) return Result<Address>::Err("empty unix socket path");
+                return unix_path(spec.substr(5));
+            }
+
+            std::string host;
+            std::string port;
+            if (!spec.empty() && spec[0] == '[') {
+                size_t close = spec.find("]:");
+                if (close == std::string::npos) return Result<Address>::Err("invalid address: " + spec);
+                host = spec.substr(1, close - 1);
+                port = spec.substr(close + 2);
+            } else {
+                size_t colon = spec.rfind(':');
+                if (colon == std::string::npos) return Result<Address>::Err("missing port: " + spec);
+                host = spec.substr(0, colon);
+                port = spec.substr(colon + 1);
+                if (host.find(':') != std::string::npos) {
+                    return Result<Address>::Err("IPv6 host must be bracketed: " + spec);
+                }
+            }
+
+            char* end = nullptr;
+            unsigned long port_num = std::strtoul(port.c_str(), &end, 10);
+            if (port.empty() || *end != '\0' || port_num > 65535) {
+                return Result<Address>::Err("invalid port: " + spec);
+            }
+
+            unsigned char probe[sizeof(struct in6_addr)];
+            int family = host.find(':') != std::string::npos ? AF_INET6 : AF_INET;
+            if (inet_pton(family, host.c_str(), probe) != 1) {
+                return Result<Address>::Err("invalid host: " + spec);
+            }
+            return Result<Address>::Ok(Address(host, static_cast<uint16_t>(port_num)));
+        }
 
         std::string Address::ip() const {
-            char buf[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof(buf));
+            char buf[INET6_ADDRSTRLEN] = "";
+            if (is_ipv4()) {
+                inet_ntop(AF_INET, &reinterpret_cast<const struct sockaddr_in*>(&addr_)->sin_addr, buf, sizeof(buf));
+            } else if (is_ipv6()) {
+                inet_ntop(AF_INET6, &reinterpret_cast<const struct sockaddr_in6*>(&addr_)->sin6_addr, buf, sizeof(buf));
+            }
             return buf;
         }
 
         uint16_t Address::port() const {
-            return ntohs(addr_.sin_port);
+            if (is_ipv4()) return ntohs(reinterpret_cast<const struct sockaddr_in*>(&addr_)->sin_port);
+            if (is_ipv6()) return ntohs(reinterpret_cast<const struct sockaddr_in6*>(&addr_)->sin6_port);
+            return 0;
+        }
+
+        std::string Address::path() const {
+            if (!is_unix()) return "";
+            const auto* un = reinterpret_cast<const struct sockaddr_un*>(&addr_);
+            size_t offset = offsetof(struct sockaddr_un, sun_path);
+            if (len_ <= offset) return "";  // Unnamed (e.g. an accepted peer)
+
+            size_t n = len_ - offset;
+            if (un->sun_path[0] == '\0') {
+                return "@" + std::string(un->sun_path + 1, n - 1);
+            }
+            return std::string(un->sun_path, strnlen(un->sun_path, n));
         }
 
         std::string Address::to_string() const {
             std::stringstream ss;
-            ss << ip() << ":" << port();
+            if (is_unix()) ss << "unix:" << path();
+            else if (is_ipv6()) ss << "[" << ip() << "]:" << port();
+            else ss << ip() << ":" << port();
             return ss.str();
         }
 
@@ -35,10 +139,6 @@ namespace eventcore {
             return reinterpret_cast<const struct sockaddr*>(&addr_);
         }
 
-        socklen_t Address::socklen() const {
-            return sizeof(addr_);
-        }
-
         Address Address::from_sockaddr(const struct sockaddr_in& addr) {
             return Address(addr);
         }
@@ -1,30 +1,193 @@
 #include "eventcore/net/buffer.h"
+#include "eventcore/net/read_scratch.h"
 #include <sys/uio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <algorithm>
 
 namespace eventcore {
     namespace net {
 
+        constexpr size_t Buffer::kNpos;
+        constexpr size_t Buffer::kMaxIovecs;
         const char Buffer::kCRLF[] = "\r\n";
 
-        Buffer::Buffer(size_t initial_size)
-            : buffer_(kPrependSize + initial_size),
-            read_index_(kPrependSize),
-            write_index_(kPrependSize) {}
+        Buffer::Buffer(SlabPool* pool)
+            : pool_(pool ? pool : &SlabPool::default_pool()) {}
+
+        Buffer::~Buffer() {
+            clear();
+        }
+
+        Buffer::Buffer(Buffer&& other) noexcept
+            : pool_(other.pool_), segments_(std::move(other.segments_)), readable_(other.readable_) {
+                other.segments_.clear();
+                other.readable_ = 0;
+            }
+
+        Buffer& Buffer::operator=(Buffer&& other) noexcept {
+            if (this != &other) {
+                clear();
+                pool_ = other.pool_;
+                segments_ = std::move(other.segments_);
+                readable_ = other.readable_;
+                other.segments_.clear();
+                other.readable_ = 0;
+            }
+            return *this;
+        }
+
+        void Buffer::set_pool(SlabPool* pool) {
+            clear();
+            pool_ = pool ? pool : &SlabPool::default_pool();
+        }
+
+        size_t Buffer::capacity() const {
+            size_t total = 0;
+            for (const auto& seg : segments_) total += seg.slab->capacity;
+            return total;
+        }
+
+        const char* Buffer::peek() const {
+            if (segments_.empty()) return kCRLF + 2;  // Valid, empty range
+            const Segment& front = segments_.front();
+            return front.slab->data() + front.begin;
+        }
+
+        size_t Buffer::contiguous_bytes() const {
+            if (segments_.empty()) return 0;
+            return segments_.front().end - segments_.front().begin;
+        }
+
+        const char* Buffer::contiguous(size_t len) {
+            len = std::min(len, readable_);
+            if (len <= contiguous_bytes()) return peek();
+
+            Slab* slab = pool_->allocate(len);
+            copy_out(slab->data(), len);
+
+            // Drop the copied bytes from the chain, then put them back in front
+            size_t remaining = readable_;
+            retrieve(len);
+            segments_.push_front(Segment{slab, 0, len});
+            readable_ = remaining;
+            return slab->data();
+        }
+
+        size_t Buffer::find_crlf(size_t from) const {
+            size_t offset = 0;
+            for (size_t i = 0; i < segments_.size(); ++i) {
+                const Segment& seg = segments_[i];
+                const size_t len = seg.end - seg.begin;
+                if (offset + len <= from) {
+                    offset += len;
+                    continue;
+                }
+
+                const char* base = seg.slab->data() + seg.begin;
+                size_t pos = from > offset ? from - offset : 0;
+                while (pos < len) {
+                    const void* cr = memchr(base + pos, '\r', len - pos);
+                    if (!cr) break;
+                    pos = static_cast<size_t>(static_cast<const char*>(cr) - base);
+
+                    // The '\n' may be the first byte of the next non-empty slab
+                    char next = 0;
+                    if (pos + 1 < len) {
+                        next = base[pos + 1];
+                    } else {
+                        for (size_t j = i + 1; j < segments_.size(); ++j) {
+                            if (segments_[j].end > segments_[j].begin) {
+                                next = segments_[j].slab->data()[segments_[j].begin];
+                                break;
+                            }
+                        }
+                    }
+                    if (next == '\n') return offset + pos;
+                    ++pos;
+                }
+                offset += len;
+            }
+            return kNpos;
+        }
+
+        size_t Buffer::find_eol(size_t from) const {
+            size_t offset = 0;
+            for (const auto& seg : segments_) {
+                const size_t len = seg.end - seg.begin;
+                if (offset + len > from) {
+                    const char* base = seg.slab->data() + seg.begin;
+                    size_t pos = from > offset ? from - offset : 0;
+                    const void* eol = memchr(base + pos, '\n', len - pos);
+                    if (eol) return offset + static_cast<size_t>(static_cast<const char*>(eol) - base);
+                }
+                offset += len;
+            }
+            return kNpos;
+        }
+
+        void Buffer::copy_out(char* dest, size_t len) const {
+            for (const auto& seg : segments_) {
+                if (len == 0) break;
+                size_t n = std::min(len, seg.end - seg.begin);
+                memcpy(dest, seg.slab->data() + seg.begin, n);
+                dest += n;
+                len -= n;
+            }
+        }
 
         void Buffer::retrieve(size_t len) {
-            if (len < readable_bytes()) read_index_ += len;
-            else retrieve_all();
+            if (len >= readable_) {
+                retrieve_all();
+                return;
+            }
+
+            readable_ -= len;
+            while (len > 0) {
+                Segment& front = segments_.front();
+                size_t n = front.end - front.begin;
+                if (len < n) {
+                    front.begin += len;
+                    break;
+                }
+                len -= n;
+                SlabPool::release(front.slab);
+                segments_.pop_front();
+            }
         }
 
         void Buffer::retrieve_all() {
-            read_index_ = kPrependSize;
-            write_index_ = kPrependSize;
+            // Keep a uniquely owned pooled tail slab for the next append
+            while (segments_.size() > 1) {
+                SlabPool::release(segments_.front().slab);
+                segments_.pop_front();
+            }
+            if (!segments_.empty()) {
+                Segment& tail = segments_.front();
+                if (tail.slab->pool && tail.slab->refs.load(std::memory_order_acquire) == 1) {
+                    tail.begin = tail.end = 0;
+                } else {
+                    SlabPool::release(tail.slab);
+                    segments_.pop_front();
+                }
+            }
+            readable_ = 0;
+        }
+
+        void Buffer::clear() {
+            for (auto& seg : segments_) SlabPool::release(seg.slab);
+            segments_.clear();
+            readable_ = 0;
+        }
+
+        void Buffer::shrink() {
+            if (readable_ == 0) clear();
         }
 
         std::string Buffer::retrieve_as_string(size_t len) {
-            std::string result(peek(), len);
+            len = std::min(len, readable_);
+            std::string result(len, '\0');
+            copy_out(&result[0], len);
             retrieve(len);
             return result;
         }
@@ -33,10 +196,56 @@ namespace eventcore {
             return retrieve_as_string(readable_bytes());
         }
 
+        Buffer Buffer::slice(size_t len) {
+            Buffer out(pool_);
+            len = std::min(len, readable_);
+            out.readable_ = len;
+            readable_ -= len;
+
+            while (len > 0) {
+                Segment& front = segments_.front();
+                size_t n = front.end - front.begin;
+                if (len < n) {
+                    SlabPool::retain(front.slab);
+                    out.segments_.push_back(Segment{front.slab, front.begin, front.begin + len});
+                    front.begin += len;
+                    break;
+                }
+                out.segments_.push_back(front);
+                segments_.pop_front();
+                len -= n;
+            }
+            return out;
+        }
+
+        bool Buffer::tail_writable() const {
+            if (segments_.empty()) return false;
+            const Segment& tail = segments_.back();
+            // Shared slabs are read-only: another buffer may reference bytes past our end
+            return tail.end < tail.slab->capacity &&
+                tail.slab->refs.load(std::memory_order_acquire) == 1;
+        }
+
+        void Buffer::push_slab(Slab* slab, size_t used) {
+            segments_.push_back(Segment{slab, 0, used});
+            readable_ += used;
+        }
+
         void Buffer::append(const char* data, size_t len) {
-            ensure_writable(len);
-            std::copy(data, data + len, begin_write());
-            has_written(len);
+            while (len > 0) {
+                if (!tail_writable()) {
+                    // Large appends take a bigger size class instead of a long chain
+                    push_slab(pool_->allocate(std::min(len, pool_->max_slab_size())), 0);
+                }
+
+                Segment& tail = segments_.back();
+                size_t n = std::min(len, tail.slab->capacity - tail.end);
+                memcpy(tail.slab->data() + tail.end, data, n);
+                tail.end += n;
+                readable_ += n;
+                data += n;
+                len -= n;
+            }
         }
 
         void Buffer::append(const std::string& str) {
@@ -47,61 +256,78 @@ namespace eventcore {
             append(static_cast<const char*>(data), len);
         }
 
-        void Buffer::ensure_writable(size_t len) {
-            if (writable_bytes() < len) make_space(len);
+        void Buffer::append(Buffer&& other) {
+            if (&other == this) return;
+            for (auto& seg : other.segments_) {
+                if (seg.end > seg.begin) segments_.push_back(seg);
+                else SlabPool::release(seg.slab);
+            }
+            readable_ += other.readable_;
+            other.segments_.clear();
+            other.readable_ = 0;
         }
 
-        void Buffer::make_space(size_t len) {
-            if (writable_bytes() + prependable_bytes() < len + kPrependSize) {
-                buffer_.resize(write_index_ + len);
-            } else {
-                size_t readable = readable_bytes();
-                std::copy(begin() + read_index_, begin() + write_index_, begin() + kPrependSize);
-                read_index_ = kPrependSize;
-                write_index_ = read_index_ + readable;
+        size_t Buffer::peek_iovec(struct iovec* iov, size_t max) const {
+            size_t count = 0;
+            for (const auto& seg : segments_) {
+                if (count == max) break;
+                if (seg.end == seg.begin) continue;
+                iov[count].iov_base = seg.slab->data() + seg.begin;
+                iov[count].iov_len = seg.end - seg.begin;
+                ++count;
             }
+            return count;
         }
 
         ssize_t Buffer::read_from_fd(int fd) {
-            char extrabuf[65536];
-            struct iovec vec[2];
-            const size_t writable = writable_bytes();
+            struct iovec vec[kMaxIovecs];
+            size_t iovcnt = 0;
+            size_t writable = 0;
+            if (tail_writable()) {
+                Segment& tail = segments_.back();
+                writable = tail.slab->capacity - tail.end;
+                vec[0].iov_base = tail.slab->data() + tail.end;
+                vec[0].iov_len = writable;
+                iovcnt = 1;
+            }
 
-            vec[0].iov_base = begin_write();
-            vec[0].iov_len = writable;
-            vec[1].iov_base = extrabuf;
-            vec[1].iov_len = sizeof(extrabuf);
+            ReadScratch& scratch = ReadScratch::local(pool_);
+            const size_t spares = scratch.prepare(vec + iovcnt, kMaxIovecs - iovcnt);
+            size_t area = writable;
+            for (size_t i = iovcnt; i < iovcnt + spares; ++i) area += vec[i].iov_len;
 
-            const int iovcnt = (writable < sizeof(extrabuf)) ? 2 : 1;
-            const ssize_t n = ::readv(fd, vec, iovcnt);
+            const ssize_t n = ::readv(fd, vec, static_cast<int>(iovcnt + spares));
+            if (n <= 0) return n;
+            scratch.record_read();
 
-            if (n < 0) return n;
-            else if (static_cast<size_t>(n) <= writable) write_index_ += n;
-            else {
-                write_index_ = buffer_.size();
-                append(extrabuf, n - writable);
+            const size_t received = static_cast<size_t>(n);
+            const size_t in_tail = std::min(received, writable);
+            if (in_tail > 0) {
+                segments_.back().end += in_tail;
+                readable_ += in_tail;
             }
-            return n;
-        }
-
-        const char* Buffer::find_crlf() const {
-            const char* crlf = std::search(peek(), begin_write(), kCRLF, kCRLF + 2);
-            return crlf == begin_write() ? nullptr : crlf;
-        }
 
-        const char* Buffer::find_crlf(const char* start) const {
-            const char* crlf = std::search(start, begin_write(), kCRLF, kCRLF + 2);
-            return crlf == begin_write() ? nullptr : crlf;
+            // Adopt the scratch slabs that received the rest instead of copying it
+            size_t remaining = received - in_tail;
+            size_t adopted = 0;
+            while (remaining > 0) {
+                Slab* slab = scratch.spare(adopted++);
+                size_t used = std::min(remaining, static_cast<size_t>(slab->capacity));
+                push_slab(slab, used);
+                remaining -= used;
+            }
+            if (adopted > 0) scratch.adopt(adopted, received == area);
+            return n;
         }
 
-        const char* Buffer::find_eol() const {
-            const void* eol = memchr(peek(), '\n', readable_bytes());
-            return static_cast<const char*>(eol);
-        }
+        ssize_t Buffer::write_to_fd(int fd) {
+            struct iovec iov[kMaxIovecs];
+            size_t count = peek_iovec(iov, kMaxIovecs);
+            if (count == 0) return 0;
 
-        const char* Buffer::find_eol(const char* start) const {
-            const void* eol = memchr(start, '\n', begin_write() - start);
-            return static_cast<const char*>(eol);
+            ssize_t n = ::writev(fd, iov, static_cast<int>(count));
+            if (n > 0) retrieve(static_cast<size_t>(n));
+            return n;
         }
 
     } // namespace net
@@ -23,6 +23,7 @@ namespace eventcore {
 
         EpollPoller::EpollPoller() : epfd_(epoll_create1(EPOLL_CLOEXEC)), events_(16) {
             if (epfd_ < 0) throw std::runtime_error("epoll_create1 failed");
+            event_capacity_.store(events_.size(), std::memory_order_relaxed);
         }
 
         EpollPoller::~EpollPoller() { 
@@ -55,7 +56,9 @@ namespace eventcore {
 
             if (events & kReadable) ev.events |= EPOLLIN;
             if (events & kWritable) ev.events |= EPOLLOUT;
-            ev.events |= EPOLLET;
+            // Registrations are one-shot; modify() is how callers re-arm them.
+            // EPOLL_CTL_MOD re-evaluates readiness, so pending input is reported again.
+            ev.events |= EPOLLET | EPOLLONESHOT;
 
             return epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) == 0;
         }
@@ -72,8 +75,11 @@ namespace eventcore {
             int numEvents = epoll_wait(epfd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
 
             if (numEvents > 0) {
+                ready_time_ = std::chrono::steady_clock::now();
                 if (static_cast<size_t>(numEvents) == events_.size()) {
+                    saturated_polls_.fetch_add(1, std::memory_order_relaxed);
                     events_.resize(events_.size() * 2);
+                    event_capacity_.store(events_.size(), std::memory_order_relaxed);
                 }
 
                 for (int i = 0; i < numEvents; ++i) {
@@ -100,6 +106,13 @@ namespace eventcore {
             return numEvents;
         }
 
+        PollerStats EpollPoller::stats() const {
+            PollerStats stats;
+            stats.saturated_polls = saturated_polls_.load(std::memory_order_relaxed);
+            stats.event_capacity = event_capacity_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
 #endif // __linux__
 
         SelectPoller::SelectPoller() : max_fd_(-1) {}
@@ -163,6 +176,7 @@ namespace eventcore {
             tv.tv_usec = (timeout_ms % 1000) * 1000;
 
             int ret = ::select(max_fd_ + 1, &readfds, &writefds, &exceptfds, &tv);
+            if (ret > 0) ready_time_ = std::chrono::steady_clock::now();
 
             if (ret > 0) {
                 for (const auto& pair : fds_) {
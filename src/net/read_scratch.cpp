@@ -0,0 +1,125 @@
+#include "eventcore/net/read_scratch.h"
+#include <algorithm>
+#include <mutex>
+
+namespace eventcore {
+    namespace net {
+
+        constexpr size_t ReadScratch::kTargetBytes;
+
+        namespace {
+
+            struct Registry {
+                std::mutex mutex;
+                std::vector<ReadScratch*> live;
+                ReadStats retired;
+            };
+
+            Registry& registry() {
+                // Leaked so thread-local scratch areas can unregister at any point of shutdown
+                static Registry* instance = new Registry();
+                return *instance;
+            }
+
+        } // namespace
+
+        ReadScratch::ReadScratch() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.live.push_back(this);
+        }
+
+        ReadScratch::~ReadScratch() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            release_spares();
+            reg.retired.reads += reads_.load(std::memory_order_relaxed);
+            reg.retired.overflow_reads += overflow_reads_.load(std::memory_order_relaxed);
+            reg.retired.adopted_slabs += adopted_slabs_.load(std::memory_order_relaxed);
+            reg.retired.exhausted_reads += exhausted_reads_.load(std::memory_order_relaxed);
+            reg.live.erase(std::remove(reg.live.begin(), reg.live.end(), this), reg.live.end());
+        }
+
+        ReadScratch& ReadScratch::local(SlabPool* pool) {
+            static thread_local ReadScratch scratch;
+            if (scratch.pool_ != pool) {
+                std::lock_guard<std::mutex> lock(registry().mutex);
+                scratch.release_spares();
+                scratch.pool_ = pool;
+            }
+            return scratch;
+        }
+
+        void ReadScratch::release_spares() {
+            for (Slab* slab : spares_) SlabPool::release(slab);
+            spares_.clear();
+            spare_count_.store(0, std::memory_order_relaxed);
+        }
+
+        size_t ReadScratch::prepare(struct iovec* iov, size_t max) {
+            const size_t slab_size = pool_->slab_size();
+            const size_t wanted = std::min(max, (kTargetBytes + slab_size - 1) / slab_size);
+            if (spares_.size() < wanted) {
+                while (spares_.size() < wanted) {
+                    spares_.push_back(pool_->allocate());
+                }
+                spare_count_.store(spares_.size(), std::memory_order_relaxed);
+            }
+
+            const size_t count = std::min(wanted, spares_.size());
+            for (size_t i = 0; i < count; ++i) {
+                iov[i].iov_base = spares_[i]->data();
+                iov[i].iov_len = spares_[i]->capacity;
+            }
+            return count;
+        }
+
+        void ReadScratch::adopt(size_t count, bool exhausted) {
+            spares_.erase(spares_.begin(), spares_.begin() + static_cast<std::ptrdiff_t>(count));
+            spare_count_.store(spares_.size(), std::memory_order_relaxed);
+            bump(overflow_reads_);
+            if (exhausted) bump(exhausted_reads_);
+            bump(adopted_slabs_, count);
+        }
+
+        void ReadScratch::record_read() {
+            bump(reads_);
+        }
+
+        ReadStats ReadScratch::stats() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            ReadStats total = reg.retired;
+            for (const ReadScratch* scratch : reg.live) {
+                total.reads += scratch->reads_.load(std::memory_order_relaxed);
+                total.overflow_reads += scratch->overflow_reads_.load(std::memory_order_relaxed);
+                total.adopted_slabs += scratch->adopted_slabs_.load(std::memory_order_relaxed);
+                total.exhausted_reads += scratch->exhausted_reads_.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        size_t ReadScratch::held(const SlabPool* pool) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            size_t count = 0;
+            for (const ReadScratch* scratch : reg.live) {
+                // pool_ only changes under the registry mutex; spares_ belongs to its thread
+                if (scratch->pool_ == pool) count += scratch->spare_count_.load(std::memory_order_relaxed);
+            }
+            return count;
+        }
+
+        void ReadScratch::forget_pool(SlabPool* pool) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for (ReadScratch* scratch : reg.live) {
+                if (scratch->pool_ == pool) {
+                    scratch->release_spares();
+                    scratch->pool_ = nullptr;
+                }
+            }
+        }
+
+    } // namespace net
+} // namespace eventcore
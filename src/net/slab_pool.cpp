@@ -0,0 +1,171 @@
+#include "eventcore/net/slab_pool.h"
+#include "eventcore/net/read_scratch.h"
+#include <algorithm>
+#include <new>
+
+namespace eventcore {
+    namespace net {
+
+        constexpr size_t SlabPoolStats::kNumClasses;
+        constexpr size_t SlabPool::kDefaultSlabSize;
+        constexpr size_t SlabPool::kDefaultMaxCached;
+        constexpr size_t SlabPool::kNumClasses;
+
+        namespace {
+
+            Slab* new_slab(SlabPool* pool, size_t capacity) {
+                void* mem = ::operator new(sizeof(Slab) + capacity);
+                Slab* slab = new (mem) Slab;
+                slab->pool = pool;
+                slab->refs.store(1, std::memory_order_relaxed);
+                slab->capacity = static_cast<uint32_t>(capacity);
+                return slab;
+            }
+
+            void delete_slab(Slab* slab) {
+                slab->~Slab();
+                ::operator delete(slab);
+            }
+
+        } // namespace
+
+        size_t SlabPoolStats::bytes_in_use() const {
+            size_t total = oversize_bytes;
+            for (const auto& c : classes) total += c.slab_size * c.in_use;
+            return total;
+        }
+
+        size_t SlabPoolStats::bytes_cached() const {
+            size_t total = 0;
+            for (const auto& c : classes) total += c.slab_size * c.cached;
+            return total;
+        }
+
+        SlabPoolStats& SlabPoolStats::operator+=(const SlabPoolStats& other) {
+            for (size_t i = 0; i < kNumClasses; ++i) {
+                if (classes[i].slab_size == 0) classes[i].slab_size = other.classes[i].slab_size;
+                classes[i].in_use += other.classes[i].in_use;
+                classes[i].cached += other.classes[i].cached;
+            }
+            scratch += other.scratch;
+            oversize_in_use += other.oversize_in_use;
+            oversize_bytes += other.oversize_bytes;
+            return *this;
+        }
+
+        SlabPool::SlabPool(size_t slab_size, size_t max_cached)
+            : max_cached_(max_cached) {
+                for (size_t i = 0; i < kNumClasses; ++i) {
+                    class_size_[i] = slab_size << (2 * i);
+                }
+            }
+
+        SlabPool::~SlabPool() {
+            ReadScratch::forget_pool(this);
+            trim();
+        }
+
+        size_t SlabPool::class_of(size_t capacity) const {
+            for (size_t i = 0; i < kNumClasses; ++i) {
+                if (capacity <= class_size_[i]) return i;
+            }
+            return kNumClasses;
+        }
+
+        Slab* SlabPool::allocate(size_t min_capacity) {
+            const size_t cls = class_of(min_capacity);
+            if (cls == kNumClasses) {
+                oversize_in_use_.fetch_add(1, std::memory_order_relaxed);
+                oversize_bytes_.fetch_add(min_capacity, std::memory_order_relaxed);
+                return new_slab(this, min_capacity);
+            }
+
+            FreeList& list = classes_[cls];
+            list.in_use.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!list.slabs.empty()) {
+                    Slab* slab = list.slabs.back();
+                    list.slabs.pop_back();
+                    slab->refs.store(1, std::memory_order_relaxed);
+                    return slab;
+                }
+            }
+            return new_slab(this, class_size_[cls]);
+        }
+
+        void SlabPool::release(Slab* slab) {
+            if (slab->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            slab->pool->recycle(slab);
+        }
+
+        void SlabPool::recycle(Slab* slab) {
+            const size_t cls = class_of(slab->capacity);
+            if (cls == kNumClasses) {
+                oversize_in_use_.fetch_sub(1, std::memory_order_relaxed);
+                oversize_bytes_.fetch_sub(slab->capacity, std::memory_order_relaxed);
+                delete_slab(slab);
+                return;
+            }
+
+            FreeList& list = classes_[cls];
+            list.in_use.fetch_sub(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                // Every class caches at most the same number of bytes
+                if (list.slabs.size() < (max_cached_ >> (2 * cls))) {
+                    list.slabs.push_back(slab);
+                    return;
+                }
+            }
+            delete_slab(slab);
+        }
+
+        size_t SlabPool::cached() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t total = 0;
+            for (const auto& list : classes_) total += list.slabs.size();
+            return total;
+        }
+
+        size_t SlabPool::in_use() const {
+            size_t total = oversize_in_use_.load(std::memory_order_relaxed);
+            for (const auto& list : classes_) total += list.in_use.load(std::memory_order_relaxed);
+            return total;
+        }
+
+        SlabPoolStats SlabPool::stats() const {
+            SlabPoolStats stats;
+            stats.scratch = ReadScratch::held(this);  // Before mutex_: see forget_pool
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < kNumClasses; ++i) {
+                stats.classes[i].slab_size = class_size_[i];
+                stats.classes[i].in_use = classes_[i].in_use.load(std::memory_order_relaxed);
+                stats.classes[i].cached = classes_[i].slabs.size();
+            }
+            stats.classes[0].in_use -= std::min(stats.scratch, stats.classes[0].in_use);
+            stats.oversize_in_use = oversize_in_use_.load(std::memory_order_relaxed);
+            stats.oversize_bytes = oversize_bytes_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        void SlabPool::trim() {
+            std::vector<Slab*> freed;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto& list : classes_) {
+                    freed.insert(freed.end(), list.slabs.begin(), list.slabs.end());
+                    list.slabs.clear();
+                }
+            }
+            for (Slab* slab : freed) delete_slab(slab);
+        }
+
+        SlabPool& SlabPool::default_pool() {
+            // Never destroyed, so buffers in static objects can release safely
+            static SlabPool* pool = new SlabPool();
+            return *pool;
+        }
+
+    } // namespace net
+} // namespace eventcore
@@ -31,45 +31,71 @@ namespace eventcore {
         }
         Result<void> Socket::bind(const Address& addr) {
             if (::bind(fd_, addr.sockaddr(), addr.socklen()) < 0) {
-                return Result<void>::Err(std::string("bind failed: ") + strerror(errno));
+                return Result<void>::Err(Error::from_errno(errno, "bind failed"));
             }
             return Result<void>::Ok();
         }
 
         Result<void> Socket::listen(int backlog) {
             if (::listen(fd_, backlog) < 0) {
-                return Result<void>::Err(std::string("listen failed: ") + strerror(errno));
+                return Result<void>::Err(Error::from_errno(errno, "listen failed"));
             }
             return Result<void>::Ok();
         }
 
         Result<void> Socket::connect(const Address& addr) {
             if (::connect(fd_, addr.sockaddr(), addr.socklen()) < 0) {
-                return Result<void>::Err(std::string("connect failed: ") + strerror(errno));
+                return Result<void>::Err(Error::from_errno(errno, "connect failed"));
             }
             return Result<void>::Ok();
         }
 
         Result<Socket> Socket::accept() {
-            struct sockaddr_in addr;
+            return accept(nullptr, 0);
+        }
+
+        Result<Socket> Socket::accept(Address* peer_addr, int flags) {
+            struct sockaddr_storage addr;
             socklen_t len = sizeof(addr);
-            int client_fd = ::accept(fd_, reinterpret_cast<struct sockaddr*>(&addr), &len);
+            int client_fd = ::accept4(fd_, reinterpret_cast<struct sockaddr*>(&addr), &len, flags);
             if (client_fd < 0) {
-                return Result<Socket>::Err(std::string("accept failed: ") + strerror(errno));
+                return Result<Socket>::Err(Error::from_errno(errno, "accept failed"));
+            }
+            if (peer_addr) {
+                *peer_addr = Address(reinterpret_cast<const struct sockaddr*>(&addr), len);
             }
             return Result<Socket>::Ok(Socket(client_fd));
         }
 
 
+        Result<Address> Socket::local_address() const {
+            struct sockaddr_storage addr;
+            socklen_t len = sizeof(addr);
+            if (::getsockname(fd_, reinterpret_cast<struct sockaddr*>(&addr), &len) < 0) {
+                return Result<Address>::Err(Error::from_errno(errno, "getsockname failed"));
+            }
+            return Result<Address>::Ok(Address(reinterpret_cast<const struct sockaddr*>(&addr), len));
+        }
+
         Result<size_t> Socket::send(const void* data, size_t len) {
             ssize_t n = ::send(fd_, data, len, MSG_NOSIGNAL);
-            if (n < 0) return Result<size_t>::Err(std::string("send failed: ") + strerror(errno));
+            if (n < 0) return Result<size_t>::Err(Error::from_errno(errno, "send failed"));
+            return Result<size_t>::Ok(static_cast<size_t>(n));
+        }
+
+        Result<size_t> Socket::sendv(const struct iovec* iov, size_t count) {
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = const_cast<struct iovec*>(iov);
+            msg.msg_iovlen = count;
+            ssize_t n = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+            if (n < 0) return Result<size_t>::Err(Error::from_errno(errno, "sendmsg failed"));
             return Result<size_t>::Ok(static_cast<size_t>(n));
         }
 
         Result<size_t> Socket::recv(void* data, size_t len) {
             ssize_t n = ::recv(fd_, data, len, 0);
-            if (n < 0) return Result<size_t>::Err(std::string("recv failed: ") + strerror(errno));
+            if (n < 0) return Result<size_t>::Err(Error::from_errno(errno, "recv failed"));
             return Result<size_t>::Ok(static_cast<size_t>(n));
         }
 
@@ -77,7 +103,7 @@ namespace eventcore {
         Result<void> Socket::set_nonblocking(bool enable) {
             int flags = fcntl(fd_, F_GETFL, 0);
             if (flags < 0) {
-                return Result<void>::Err("fcntl F_GETFL failed");
+                return Result<void>::Err(Error::from_errno(errno, "fcntl F_GETFL failed"));
             }
 
             if (enable) {
@@ -87,7 +113,7 @@ namespace eventcore {
             }
 
             if (fcntl(fd_, F_SETFL, flags) < 0) {
-                return Result<void>::Err("fcntl F_SETFL failed");
+                return Result<void>::Err(Error::from_errno(errno, "fcntl F_SETFL failed"));
             }
             return Result<void>::Ok();
         }
@@ -95,7 +121,7 @@ namespace eventcore {
         Result<void> Socket::set_reuseaddr(bool enable) {
             int optval = enable ? 1 : 0;
             if (setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0) {
-                return Result<void>::Err("setsockopt SO_REUSEADDR failed");
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt SO_REUSEADDR failed"));
             }
             return Result<void>::Ok();
         }
@@ -104,7 +130,7 @@ namespace eventcore {
 #ifdef SO_REUSEPORT
             int optval = enable ? 1 : 0;
             if (setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)) < 0) {
-                return Result<void>::Err("setsockopt SO_REUSEPORT failed");
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt SO_REUSEPORT failed"));
             }
 #endif
             return Result<void>::Ok();
@@ -113,7 +139,7 @@ namespace eventcore {
         Result<void> Socket::set_nodelay(bool enable) {
             int optval = enable ? 1 : 0;
             if (setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval)) < 0) {
-                return Result<void>::Err("setsockopt TCP_NODELAY failed");
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt TCP_NODELAY failed"));
             }
             return Result<void>::Ok();
         }
@@ -121,10 +147,59 @@ namespace eventcore {
         Result<void> Socket::set_keepalive(bool enable) {
             int optval = enable ? 1 : 0;
             if (setsockopt(fd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval)) < 0) {
-                return Result<void>::Err("setsockopt SO_KEEPALIVE failed");
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt SO_KEEPALIVE failed"));
             }
             return Result<void>::Ok();
         }
+
+        Result<void> Socket::set_defer_accept(int timeout_sec) {
+#ifdef TCP_DEFER_ACCEPT
+            int optval = timeout_sec;
+            if (setsockopt(fd_, IPPROTO_TCP, TCP_DEFER_ACCEPT, &optval, sizeof(optval)) < 0) {
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt TCP_DEFER_ACCEPT failed"));
+            }
+#endif
+            return Result<void>::Ok();
+        }
+
+        Result<void> Socket::set_fastopen(int queue_len) {
+#ifdef TCP_FASTOPEN
+            int optval = queue_len;
+            if (setsockopt(fd_, IPPROTO_TCP, TCP_FASTOPEN, &optval, sizeof(optval)) < 0) {
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt TCP_FASTOPEN failed"));
+            }
+#endif
+            return Result<void>::Ok();
+        }
+
+        Result<void> Socket::set_ipv6_only(bool enable) {
+            int optval = enable ? 1 : 0;
+            if (setsockopt(fd_, IPPROTO_IPV6, IPV6_V6ONLY, &optval, sizeof(optval)) < 0) {
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt IPV6_V6ONLY failed"));
+            }
+            return Result<void>::Ok();
+        }
+
+        Result<void> Socket::set_busy_poll(int usec) {
+#ifdef SO_BUSY_POLL
+            int optval = usec;
+            if (setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL, &optval, sizeof(optval)) < 0) {
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt SO_BUSY_POLL failed"));
+            }
+#endif
+            return Result<void>::Ok();
+        }
+
+        Result<void> Socket::set_prefer_busy_poll(bool enable) {
+#ifdef SO_PREFER_BUSY_POLL
+            int optval = enable ? 1 : 0;
+            if (setsockopt(fd_, SOL_SOCKET, SO_PREFER_BUSY_POLL, &optval, sizeof(optval)) < 0) {
+                return Result<void>::Err(Error::from_errno(errno, "setsockopt SO_PREFER_BUSY_POLL failed"));
+            }
+#endif
+            return Result<void>::Ok();
+        }
+
         void Socket::shutdown_write() {
             ::shutdown(fd_, SHUT_WR);
         }
@@ -136,15 +211,19 @@ namespace eventcore {
             }
         }
 
-        Result<Socket> Socket::create_tcp() {
-            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
-            if (fd < 0) return Result<Socket>::Err(std::string("socket creation failed: ") + strerror(errno));
+        Result<Socket> Socket::create_tcp(int family) {
+            int fd = ::socket(family, SOCK_STREAM, 0);
+            if (fd < 0) return Result<Socket>::Err(Error::from_errno(errno, "socket creation failed"));
             return Result<Socket>::Ok(Socket(fd));
         }
 
+        Result<Socket> Socket::create_unix() {
+            return create_tcp(AF_UNIX);
+        }
+
         Result<Socket> Socket::create_udp() {
             int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
-            if (fd < 0) return Result<Socket>::Err(std::string("socket creation failed: ") + strerror(errno));
+            if (fd < 0) return Result<Socket>::Err(Error::from_errno(errno, "socket creation failed"));
             return Result<Socket>::Ok(Socket(fd));
         }
 
@@ -1,82 +1,123 @@
 #include "eventcore/server/connection_pool.h"
+#include <algorithm>
+#include <cassert>
+#include <new>
 
 namespace eventcore {
     namespace server {
 
-        ConnectionPool::ConnectionPool(size_t size) {
-            pool_.resize(size);
-            free_indices_.reserve(size);
+        constexpr uint32_t ConnectionPool::Shard::kNoSlot;
 
-            for (size_t i = 0; i < size; ++i) {
-                pool_[i].in_use = false;
-                free_indices_.push_back(i);
+        ConnectionPool::Shard::Shard(size_t capacity, HugePageMode huge_pages)
+            : arena_(sizeof(http::Connection), capacity, huge_pages),
+            slots_(capacity),
+            available_(capacity) {
+                free_list_.reserve(capacity);
+                // Push in reverse so the lowest slot is handed out first
+                for (size_t i = capacity; i-- > 0;) {
+                    free_list_.push_back(static_cast<uint32_t>(i));
+                }
             }
-        }
 
-        http::ConnectionPtr ConnectionPool::acquire(
-                int fd, http::Connection::RequestHandler handler) {
+        ConnectionPool::Shard::~Shard() {
+            // Destroy the connections while the arena still backs them. A
+            // ConnectionPtr held anywhere else would dangle once it is unmapped.
+            for (const Slot& entry : slots_) {
+                assert((!entry.conn || entry.conn.use_count() == 1) && "connection outlives its pool shard");
+                (void)entry;
+            }
+            slots_.clear();
+        }
 
-            std::lock_guard<std::mutex> lock(mutex_);
+        http::ConnectionPtr ConnectionPool::Shard::acquire(
+                int fd, const http::Connection::RequestHandler& handler, uint32_t* slot) {
 
-            if (free_indices_.empty()) {
+            if (free_list_.empty() || fd < 0) {
                 return nullptr;
             }
 
-            size_t idx = free_indices_.back();
-            free_indices_.pop_back();
-
-            auto& entry = pool_[idx];
-
+            uint32_t idx = free_list_.back();
+            Slot& entry = slots_[idx];
             if (!entry.conn) {
-                entry.conn = std::make_shared<http::Connection>(
-                        net::Socket(fd), handler);
+                void* mem = arena_.slot(idx);
+                if (!mem) {
+                    return nullptr;
+                }
+                auto* conn = new (mem) http::Connection(net::Socket(fd), handler);
+                entry.conn = http::ConnectionPtr(conn, [](http::Connection* c) { c->~Connection(); });
             } else {
                 entry.conn->reset(fd);
             }
-
+            free_list_.pop_back();
+            available_.fetch_sub(1, std::memory_order_relaxed);
+            entry.fd = fd;
             entry.in_use = true;
-            entry.last_used = std::chrono::steady_clock::now();
-            fd_to_index_[fd] = idx;
 
+            size_t index = static_cast<size_t>(fd);
+            if (index >= fd_to_slot_.size()) {
+                fd_to_slot_.resize(std::max(index + 1, fd_to_slot_.size() * 2), kNoSlot);
+            }
+            fd_to_slot_[index] = idx;
+
+            if (slot) *slot = idx;
             return entry.conn;
         }
 
-        void ConnectionPool::release(int fd) {
-            std::lock_guard<std::mutex> lock(mutex_);
+        void ConnectionPool::Shard::release(uint32_t slot) {
+            Slot& entry = slots_[slot];
+            if (!entry.in_use) return;
 
-            auto it = fd_to_index_.find(fd);
-            if (it == fd_to_index_.end()) return;
-
-            size_t idx = it->second;
-            pool_[idx].in_use = false;
-            free_indices_.push_back(idx);
-            fd_to_index_.erase(it);
+            size_t index = static_cast<size_t>(entry.fd);
+            if (index < fd_to_slot_.size() && fd_to_slot_[index] == slot) {
+                fd_to_slot_[index] = kNoSlot;
+            }
+            entry.fd = -1;
+            entry.in_use = false;
+            free_list_.push_back(slot);
+            available_.fetch_add(1, std::memory_order_relaxed);
         }
 
-        size_t ConnectionPool::available() const {
-            std::lock_guard<std::mutex> lock(mutex_);
-            return free_indices_.size();
+        uint32_t ConnectionPool::Shard::slot_of(int fd) const {
+            size_t index = static_cast<size_t>(fd);
+            if (fd < 0 || index >= fd_to_slot_.size()) return kNoSlot;
+            return fd_to_slot_[index];
         }
 
-        std::vector<int> ConnectionPool::get_idle_connections(
-                std::chrono::seconds timeout) {
+        ConnectionPool::ConnectionPool(size_t size, size_t num_shards, HugePageMode huge_pages)
+            : total_size_(size) {
+            if (num_shards == 0) num_shards = 1;
+            shards_.reserve(num_shards);
+            for (size_t i = 0; i < num_shards; ++i) {
+                // Spread the remainder over the first shards
+                size_t capacity = size / num_shards + (i < size % num_shards ? 1 : 0);
+                shards_.push_back(std::make_unique<Shard>(capacity, huge_pages));
+            }
+        }
 
-            std::lock_guard<std::mutex> lock(mutex_);
-            std::vector<int> idle_fds;
-            auto now = std::chrono::steady_clock::now();
+        size_t ConnectionPool::available() const {
+            size_t total = 0;
+            for (const auto& shard : shards_) total += shard->available();
+            return total;
+        }
 
-            for (const auto& pair : fd_to_index_) {
-                int fd = pair.first;
-                size_t idx = pair.second;
+        size_t ConnectionPool::committed_bytes() const {
+            size_t total = 0;
+            for (const auto& shard : shards_) total += shard->committed_bytes();
+            return total;
+        }
 
-                const auto& entry = pool_[idx];
-                if (entry.in_use && 
-                        (now - entry.last_used) > timeout) {
-                    idle_fds.push_back(fd);
-                }
+        void ConnectionPool::register_metrics(metrics::Registry& registry) const {
+            for (size_t i = 0; i < shards_.size(); ++i) {
+                const Shard* shard = shards_[i].get();
+                const metrics::Labels labels = {{"shard", std::to_string(i)}};
+                registry.gauge_fn("eventcore_connection_pool_capacity", "Connection slots in the shard", labels,
+                        [shard]() { return static_cast<double>(shard->capacity()); });
+                registry.gauge_fn("eventcore_connection_pool_available", "Free connection slots in the shard",
+                        labels, [shard]() { return static_cast<double>(shard->available()); });
+                registry.gauge_fn("eventcore_connection_pool_committed_bytes",
+                        "Memory committed for the shard's connection objects", labels,
+                        [shard]() { return static_cast<double>(shard->committed_bytes()); });
             }
-
-            return idle_fds;
         }
 
     } // namespace server
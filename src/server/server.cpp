@@ -1,101 +1,433 @@
 #include "eventcore/server/server.h"
 #include "eventcore/core/logger.h"
+#include "eventcore/net/read_scratch.h"
+#include "eventcore/thread/affinity.h"
 #include <algorithm>
-#include <sstream>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace eventcore {
     namespace server {
 
-        Server::Server(const Config& config)
-            : config_(config),
-            pool_(config_.connection_pool_size) {  // Initialize pool
+        namespace {
+
+            // Set from the trace dump signal handler, acted on by the accept loop
+            std::atomic<bool> trace_dump_requested{false};
+
+            void request_trace_dump(int) {
+                trace_dump_requested.store(true, std::memory_order_relaxed);
+            }
+
+            // A socket file left behind by a previous run would make bind() fail.
+            // Only a socket nobody is listening on is removed: anything else at the
+            // path is an error rather than something to delete or take over.
+            void remove_stale_socket(const net::Address& addr) {
+                const std::string path = addr.path();
+                struct stat st;
+                if (::lstat(path.c_str(), &st) != 0) return;
+                if (!S_ISSOCK(st.st_mode))
+                    throw std::runtime_error("Bind " + addr.to_string() + " failed: the path exists and is not a socket");
+
+                const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                if (probe < 0)
+                    throw std::runtime_error("Failed to probe " + addr.to_string() + ": " + std::strerror(errno));
+                const bool refused = ::connect(probe, addr.sockaddr(), addr.socklen()) != 0 &&
+                    (errno == ECONNREFUSED || errno == ENOENT);
+                ::close(probe);
+                if (!refused)
+                    throw std::runtime_error("Bind " + addr.to_string() + " failed: " + std::strerror(EADDRINUSE) +
+                            " (another process is listening)");
+                ::unlink(path.c_str());
+            }
+
+            Config resolve_worker_count(Config config) {
+                if (config.num_workers == 0) {
+                    config.num_workers = std::thread::hardware_concurrency();
+                    if (config.num_workers == 0) config.num_workers = 1;
+                }
+                return config;
+            }
+
+            // Decides where each worker's loop and pool threads run. Each worker owns
+            // one ConnectionPool shard, whose connections are first touched by the
+            // worker's own loop thread and so live on its NUMA node.
+            std::vector<WorkerOptions> plan_workers(const Config& config) {
+                std::vector<WorkerOptions> plan(config.num_workers);
+
+                AffinityPolicy policy = config.affinity;
+                if (config.busy_poll && policy == AffinityPolicy::kNone) {
+                    policy = AffinityPolicy::kPerCore;
+                }
+
+                for (size_t i = 0; i < plan.size(); ++i) {
+                    auto& options = plan[i];
+                    options.pool_shard = i;
+                    options.idle_timeout = std::chrono::seconds(config.keepalive_timeout_sec);
+                    options.stall_threshold = std::chrono::milliseconds(config.loop_stall_threshold_ms);
+                    options.trace_capacity = config.trace_buffer_events;
+                    options.parser_limits.max_request_line = config.max_request_line;
+                    options.parser_limits.max_header_count = config.max_header_count;
+                    options.parser_limits.max_header_bytes = config.max_header_bytes;
+                    options.parser_limits.max_body_size = config.max_request_size;
+                    options.busy_poll = config.busy_poll;
+                    options.busy_poll_budget = std::chrono::microseconds(config.busy_poll_budget_us);
+                }
+                if (policy == AffinityPolicy::kNone) return plan;
 
-                if (config_.num_workers == 0) {
-                    config_.num_workers = std::thread::hardware_concurrency();
-                    if (config_.num_workers == 0) config_.num_workers = 1;
+                const thread::CpuTopology topology = thread::CpuTopology::detect();
+                const std::vector<int> loop_cpus = policy == AffinityPolicy::kPerPhysicalCore
+                    ? topology.physical_cores() : topology.logical_cpus();
+                if (loop_cpus.empty()) return plan;
+
+                for (size_t i = 0; i < plan.size(); ++i) {
+                    auto& options = plan[i];
+                    options.cpu = loop_cpus[i % loop_cpus.size()];
+                    options.numa_node = topology.node_of(options.cpu);
+
+                    if (config.pin_thread_pools) {
+                        if (policy == AffinityPolicy::kPerPhysicalCore) {
+                            options.pool_cpus = topology.siblings_of(options.cpu);
+                        }
+                        if (options.pool_cpus.empty()) {
+                            options.pool_cpus = topology.cpus_on_node(options.numa_node);
+                        }
+                    }
                 }
+                return plan;
+            }
+
+        } // namespace
+
+        Server::Server(const Config& config)
+            : config_(resolve_worker_count(config)),
+            worker_options_(plan_workers(config_)),
+            pool_(config_.connection_pool_size, config_.num_workers, config_.connection_huge_pages) {
+
+                if (config_.enable_metrics) register_metrics();
 
                 for (size_t i = 0; i < config_.num_workers; ++i) {
+                    if (config_.enable_metrics) worker_options_[i].metrics = &metrics_;
+                    buffer_pools_.push_back(std::make_unique<net::SlabPool>(config_.read_buffer_size));
                     workers_.push_back(std::make_unique<Worker>(
                                 &router_,
                                 config_.num_threads_per_worker,
-                                &pool_));  // Pass pool pointer
+                                &pool_,
+                                worker_options_[i],
+                                buffer_pools_.back().get()));
+                    if (worker_options_[i].cpu >= 0) {
+                        LOG_INFO("Worker ", i, " pinned to CPU ", worker_options_[i].cpu,
+                                " (node ", worker_options_[i].numa_node, ")");
+                    }
                 }
 
                 LOG_INFO("Server configured with ", config_.num_workers, " workers, ",
                         config_.num_threads_per_worker, " threads each, ",
-                        config_.connection_pool_size, " connection pool");
+                        config_.connection_pool_size, " connection pool in ",
+                        pool_.num_shards(), " shard(s), ", pool_.committed_bytes(), " bytes committed");
             }
 
         Server::~Server() {
             stop();
         }
 
-        void Server::start() {
-            if (running_) return;
+        void Server::register_metrics() {
+            accepted_ = &metrics_.counter("eventcore_connections_accepted_total",
+                    "Connections accepted on all listeners");
+            accept_errors_ = &metrics_.counter("eventcore_accept_errors_total",
+                    "Failed accept() calls, not counting an empty backlog");
+            metrics_.gauge_fn("eventcore_buffer_pool_bytes_in_use", "Buffer slab bytes held by connections", {},
+                    [this]() { return static_cast<double>(buffer_pool_stats().bytes_in_use()); });
+            metrics_.gauge_fn("eventcore_buffer_pool_bytes_cached", "Free buffer slab bytes kept for reuse", {},
+                    [this]() { return static_cast<double>(buffer_pool_stats().bytes_cached()); });
+            pool_.register_metrics(metrics_);
+        }
 
-            auto result = net::Socket::create_tcp();
-            if (result.is_err())
-                throw std::runtime_error("Failed to create socket: " + result.error());
-            listen_socket_ = std::move(result.value());
+        // Called from start(), after the application registered its routes, so a
+        // path the application already handles is not taken over.
+        void Server::register_builtin_routes() {
+            if (builtin_routes_registered_) return;
+            builtin_routes_registered_ = true;
+
+            auto path_is_free = [this](const std::string& path, const char* what) {
+                if (path.empty()) return false;
+                if (router_.has_route(http::Method::GET, path)) {
+                    LOG_WARN("Not serving ", what, " at ", path, ": the application already routes it");
+                    return false;
+                }
+                return true;
+            };
+
+            if (config_.enable_metrics && path_is_free(config_.metrics_path, "metrics")) {
+                router_.get(config_.metrics_path, [this](const http::Request&) {
+                        http::Response response;
+                        response.set_content_type("text/plain; version=0.0.4");
+                        response.set_body(metrics_.render());
+                        return response;
+                        });
+            }
+            if (config_.trace_buffer_events > 0 && path_is_free(config_.trace_path, "the flight recorder")) {
+                register_trace_route();
+            }
+        }
+
+        void Server::register_trace_route() {
+            router_.get(config_.trace_path, [this](const http::Request& request) {
+                    http::Response response;
+                    const std::vector<trace::Event> events = trace_events();
+                    if (request.query().find("format=json") != std::string::npos) {
+                        response.set_content_type("application/json");
+                        response.set_body(trace::to_chrome_json(events));
+                    } else {
+                        response.set_content_type("application/octet-stream");
+                        response.set_body(trace::serialize(events));
+                    }
+                    return response;
+                    });
+        }
+
+        std::vector<trace::Event> Server::trace_events() const {
+            std::vector<trace::Event> events;
+            for (const auto& worker : workers_) {
+                if (const trace::FlightRecorder* recorder = worker->flight_recorder()) {
+                    std::vector<trace::Event> recorded = recorder->snapshot();
+                    events.insert(events.end(), recorded.begin(), recorded.end());
+                }
+            }
+            std::stable_sort(events.begin(), events.end(), [](const trace::Event& a, const trace::Event& b) {
+                    return a.timestamp_ns < b.timestamp_ns;
+                    });
+            return events;
+        }
+
+        Result<void> Server::dump_trace(const std::string& path) const {
+            return trace::write_file(path, trace_events());
+        }
 
-            // Set socket options
-            auto reuseaddr_result = listen_socket_.set_reuseaddr(true);
-            if (reuseaddr_result.is_err())
-                throw std::runtime_error("Set reuseaddr failed: " + reuseaddr_result.error());
+        Server::Listener Server::open_listener(const net::Address& addr) {
+            Listener listener{addr, net::Socket()};
+            const std::string name = addr.to_string();
 
-            auto reuseport_result = listen_socket_.set_reuseport(config_.tcp_reuseport);
-            if (reuseport_result.is_err())
-                throw std::runtime_error("Set reuseport failed: " + reuseport_result.error());
+            auto result = net::Socket::create_tcp(addr.family());
+            if (result.is_err())
+                throw std::runtime_error("Failed to create socket for " + name + ": " + result.error());
+            net::Socket& sock = listener.socket;
+            sock = std::move(result.value());
+
+            if (addr.is_unix()) {
+                const std::string path = addr.path();
+                if (!path.empty() && path[0] != '@') remove_stale_socket(addr);
+            } else {
+                // Set socket options
+                auto reuseaddr_result = sock.set_reuseaddr(true);
+                if (reuseaddr_result.is_err())
+                    throw std::runtime_error("Set reuseaddr failed: " + reuseaddr_result.error());
+
+                auto reuseport_result = sock.set_reuseport(config_.tcp_reuseport);
+                if (reuseport_result.is_err())
+                    throw std::runtime_error("Set reuseport failed: " + reuseport_result.error());
+
+                auto nodelay_result = sock.set_nodelay(config_.tcp_nodelay);
+                if (nodelay_result.is_err())
+                    throw std::runtime_error("Set nodelay failed: " + nodelay_result.error());
+
+                auto keepalive_result = sock.set_keepalive(true);
+                if (keepalive_result.is_err())
+                    throw std::runtime_error("Set keepalive failed: " + keepalive_result.error());
+
+                if (addr.is_ipv6()) {
+                    auto v6only_result = sock.set_ipv6_only(config_.ipv6_only);
+                    if (v6only_result.is_err())
+                        throw std::runtime_error("Set ipv6 only failed: " + v6only_result.error());
+                }
 
-            auto nodelay_result = listen_socket_.set_nodelay(config_.tcp_nodelay);
-            if (nodelay_result.is_err())
-                throw std::runtime_error("Set nodelay failed: " + nodelay_result.error());
+                if (config_.tcp_defer_accept_sec > 0) {
+                    auto defer_result = sock.set_defer_accept(config_.tcp_defer_accept_sec);
+                    if (defer_result.is_err())
+                        throw std::runtime_error("Set defer accept failed: " + defer_result.error());
+                }
 
-            auto keepalive_result = listen_socket_.set_keepalive(true);
-            if (keepalive_result.is_err())
-                throw std::runtime_error("Set keepalive failed: " + keepalive_result.error());
+                if (config_.tcp_fastopen) {
+                    auto fastopen_result = sock.set_fastopen(config_.tcp_fastopen_queue_len);
+                    if (fastopen_result.is_err())
+                        throw std::runtime_error("Set fastopen failed: " + fastopen_result.error());
+                }
+            }
 
             // Bind and listen
-            net::Address addr(config_.host, config_.port);
-            auto bind_result = listen_socket_.bind(addr);
+            auto bind_result = sock.bind(addr);
             if (bind_result.is_err())
-                throw std::runtime_error("Bind failed: " + bind_result.error());
+                throw std::runtime_error("Bind " + name + " failed: " + bind_result.error());
+
+            if (!addr.is_unix()) {
+                // Record the port actually bound, which differs when port 0 was asked for
+                auto bound = sock.local_address();
+                if (bound.is_ok()) listener.address = bound.value();
+            } else {
+                struct stat st;
+                const std::string path = addr.path();
+                if (!path.empty() && path[0] != '@' && ::lstat(path.c_str(), &st) == 0) {
+                    listener.unix_dev = st.st_dev;
+                    listener.unix_ino = st.st_ino;
+                }
+            }
 
-            auto listen_result = listen_socket_.listen(config_.backlog);
+            auto listen_result = sock.listen(config_.backlog);
             if (listen_result.is_err())
                 throw std::runtime_error("Listen failed: " + listen_result.error());
 
-            auto nonblock_result = listen_socket_.set_nonblocking(true);
+            auto nonblock_result = sock.set_nonblocking(true);
             if (nonblock_result.is_err())
                 throw std::runtime_error("Set non-blocking failed: " + nonblock_result.error());
 
+            return listener;
+        }
+
+        void Server::start() {
+            if (running_) return;
+
+            std::vector<net::Address> addresses;
+            if (config_.listen_addresses.empty()) {
+                addresses.emplace_back(config_.host, config_.port);
+            }
+            for (const auto& spec : config_.listen_addresses) {
+                auto parsed = net::Address::parse(spec);
+                if (parsed.is_err())
+                    throw std::runtime_error("Invalid listen address: " + parsed.error());
+                addresses.push_back(parsed.value());
+            }
+
+            register_builtin_routes();
+
+            listeners_.clear();
+            for (const auto& addr : addresses) {
+                listeners_.push_back(open_listener(addr));
+            }
+
+            accept_poller_ = net::Poller::create();
+            for (size_t i = 0; i < listeners_.size(); ++i) {
+                if (!accept_poller_->add(listeners_[i].socket.fd(), net::Poller::kReadable,
+                            [this, i](int, int) { handle_accept(listeners_[i]); })) {
+                    throw std::runtime_error("Failed to register listen socket with poller");
+                }
+            }
+
             // Start workers
             for (auto& worker : workers_) {
                 worker->start();
             }
 
+            if (config_.trace_dump_signal > 0 && config_.trace_buffer_events > 0) {
+                struct sigaction action;
+                std::memset(&action, 0, sizeof(action));
+                action.sa_handler = request_trace_dump;
+                action.sa_flags = SA_RESTART;
+                sigemptyset(&action.sa_mask);
+                if (sigaction(config_.trace_dump_signal, &action, &previous_trace_action_) == 0) {
+                    trace_signal_installed_ = true;
+                } else {
+                    LOG_WARN("Failed to install trace dump handler for signal ", config_.trace_dump_signal,
+                            ": ", strerror(errno));
+                }
+            }
+
             running_ = true;
             accept_thread_ = std::thread(&Server::accept_loop, this);
 
-            std::stringstream ss;
-            ss << "Server started on " << config_.host << ":" << config_.port;
-            LOG_INFO(ss.str());
+            for (const auto& listener : listeners_) {
+                LOG_INFO("Server started on ", listener.address.to_string());
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(ready_mutex_);
+                local_addresses_.clear();
+                for (const auto& listener : listeners_) local_addresses_.push_back(listener.address);
+                ready_ = true;
+            }
+            ready_cv_.notify_all();
         }
 
         void Server::stop() {
             if (!running_) return;
             running_ = false;
+            {
+                std::lock_guard<std::mutex> lock(ready_mutex_);
+                ready_ = false;
+                local_addresses_.clear();
+            }
 
             if (accept_thread_.joinable()) accept_thread_.join();
             for (auto& worker : workers_) {
                 worker->stop();
             }
+            if (trace_signal_installed_) {
+                sigaction(config_.trace_dump_signal, &previous_trace_action_, nullptr);
+                trace_signal_installed_ = false;
+            }
 
-            listen_socket_.close();
+            for (auto& listener : listeners_) {
+                if (accept_poller_) accept_poller_->remove(listener.socket.fd());
+                listener.socket.close();
+
+                // Leave the path alone if it has since been replaced, e.g. by
+                // another instance that took over a stale socket
+                struct stat st;
+                const std::string path = listener.address.path();
+                if (listener.unix_ino != 0 && ::lstat(path.c_str(), &st) == 0 &&
+                        st.st_dev == listener.unix_dev && st.st_ino == listener.unix_ino) {
+                    ::unlink(path.c_str());
+                }
+            }
+            accept_poller_.reset();
+            listeners_.clear();
+
+            const net::ReadStats reads = net::ReadScratch::stats();
+            LOG_INFO("Reads: ", reads.reads, ", overflowed into scratch: ", reads.overflow_reads,
+                    " (", reads.adopted_slabs, " slabs adopted, ", reads.exhausted_reads, " filled the scratch)");
+            const net::SlabPoolStats buffers = buffer_pool_stats();
+            LOG_INFO("Buffer pools: ", buffers.bytes_in_use(), " bytes in use, ",
+                    buffers.bytes_cached(), " bytes cached");
             LOG_INFO("Server stopped");
         }
 
+        net::Address Server::local_address(size_t index) const {
+            std::lock_guard<std::mutex> lock(ready_mutex_);
+            return index < local_addresses_.size() ? local_addresses_[index] : net::Address();
+        }
+
+        std::vector<net::Address> Server::local_addresses() const {
+            std::lock_guard<std::mutex> lock(ready_mutex_);
+            return local_addresses_;
+        }
+
+        bool Server::wait_until_ready(std::chrono::milliseconds timeout) const {
+            std::unique_lock<std::mutex> lock(ready_mutex_);
+            return ready_cv_.wait_for(lock, timeout, [this]() { return ready_; });
+        }
+
+        std::vector<LoopStats> Server::worker_loop_stats() const {
+            std::vector<LoopStats> stats;
+            stats.reserve(workers_.size());
+            for (const auto& worker : workers_) {
+                stats.push_back(worker->loop_stats());
+            }
+            return stats;
+        }
+
+        size_t Server::active_connections() const {
+            size_t total = 0;
+            for (const auto& worker : workers_) total += worker->connection_count();
+            return total;
+        }
+
+        net::SlabPoolStats Server::buffer_pool_stats() const {
+            net::SlabPoolStats total;
+            for (const auto& pool : buffer_pools_) total += pool->stats();
+            return total;
+        }
+
         void Server::wait() {
             if (accept_thread_.joinable()) {
                 accept_thread_.join();
@@ -104,53 +436,60 @@ namespace eventcore {
 
         void Server::accept_loop() {
             while (running_) {
-                int accepted = 0;
-
-                for (int i = 0; i < config_.accept_batch_size && running_; ++i) {
-                    auto result = listen_socket_.accept();
-
+                int num_events = accept_poller_->poll(100);
+                if (num_events < 0 && errno != EINTR) {
+                    LOG_ERROR("Accept poller error: ", strerror(errno));
+                }
+                // The signal handler only sets a flag; the file is written here
+                if (trace_signal_installed_ && trace_dump_requested.exchange(false, std::memory_order_relaxed)) {
+                    auto result = dump_trace(config_.trace_dump_file);
                     if (result.is_ok()) {
-                        net::Socket client_socket = std::move(result.value());
-                        handle_new_connection(std::move(client_socket));
-                        accepted++;
+                        LOG_INFO("Trace dumped to ", config_.trace_dump_file);
                     } else {
-                        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                            LOG_ERROR("Accept error: ", result.error());
-                        }
-                        break;  // No more pending connections
+                        LOG_ERROR("Trace dump to ", config_.trace_dump_file, " failed: ", result.error());
                     }
                 }
-
-                if (accepted == 0) {
-                    std::this_thread::sleep_for(std::chrono::microseconds(100));
-                }
             }
         }
 
-        void Server::handle_new_connection(net::Socket client_socket) {
-            int fd = client_socket.fd();
-
-            auto request_handler = [this](const http::Request& req) {
-                return router_.route(req);
-            };
+        void Server::handle_accept(Listener& listener) {
+            for (int i = 0; i < config_.accept_batch_size && running_; ++i) {
+                net::Address peer;
+                auto result = listener.socket.accept(&peer);
 
-            auto conn = pool_.acquire(fd, request_handler);
+                if (result.is_err()) {
+                    if (!result.would_block()) {
+                        if (accept_errors_) accept_errors_->inc();
+                        LOG_ERROR("Accept error: ", result.error());
+                    }
+                    break;  // Backlog drained
+                }
 
-            if (!conn) {
-                LOG_WARN("Connection pool exhausted, rejecting connection");
-                client_socket.close();
-                return;
+                if (accepted_) accepted_->inc();
+                handle_new_connection(std::move(result.value()), peer);
             }
 
-            client_socket.release();
+            // Re-arm the one-shot registration; if the batch limit left connections
+            // in the backlog the poller reports the listen socket ready again.
+            accept_poller_->modify(listener.socket.fd(), net::Poller::kReadable);
+        }
 
-            Worker* worker = next_worker();
-            if (worker) {
-                worker->add_connection(conn);
-            } else {
-                LOG_ERROR("No available workers");
-                pool_.release(fd);
+        void Server::handle_new_connection(net::Socket client_socket, const net::Address& peer) {
+            int fd = client_socket.fd();
+            LOG_DEBUG("Accepted connection from ", peer.to_string(), " on fd ", fd);
+
+            if (config_.busy_poll && config_.so_busy_poll_us > 0 && !peer.is_unix()) {
+                auto busy_result = client_socket.set_busy_poll(config_.so_busy_poll_us);
+                if (busy_result.is_ok()) {
+                    busy_result = client_socket.set_prefer_busy_poll(true);
+                }
+                if (busy_result.is_err()) {
+                    LOG_DEBUG("Busy poll not applied on fd ", fd, ": ", busy_result.error());
+                }
             }
+
+            // The worker acquires the pooled Connection on its own thread
+            next_worker()->add_connection(std::move(client_socket));
         }
 
         Worker* Server::next_worker() {
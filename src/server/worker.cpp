@@ -1,7 +1,12 @@
 #include "eventcore/server/worker.h"
 #include "eventcore/core/logger.h"
+#include "eventcore/thread/affinity.h"
 #include <unistd.h>
+#include <sys/socket.h>
 #include <cstring>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 #include <sstream>
 
 namespace eventcore {
@@ -9,23 +14,131 @@ namespace eventcore {
 
         Worker::Worker(const http::Router* router,
                 size_t thread_pool_size,
-                ConnectionPool* pool)
-            : router_(router),
-            pool_(pool),
+                ConnectionPool* pool,
+                const WorkerOptions& options,
+                net::SlabPool* buffer_pool)
+            : shard_(&pool->shard(options.pool_shard)),
+            buffer_pool_(buffer_pool),
+            last_timeout_check_(std::chrono::steady_clock::now()),
+            router_(router),
+            options_(options),
             thread_pool_(std::make_unique<thread::ThreadPool>(thread_pool_size)),
-            last_timeout_check_(std::chrono::steady_clock::now()) 
+            request_handler_([this](const http::Request& req) { return handle_request(req); })
         {
             poller_ = net::Poller::create();
             if (!poller_) {
                 throw std::runtime_error("Failed to create poller");
             }
+
+#ifdef __linux__
+            wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+            int pipe_fds[2];
+            if (pipe(pipe_fds) == 0) {
+                wakeup_fd_ = pipe_fds[0];
+                wakeup_write_fd_ = pipe_fds[1];
+            }
+#endif
+            if (wakeup_fd_ < 0 ||
+                    !poller_->add(wakeup_fd_, net::Poller::kReadable, [this](int, int) { handle_wakeup(); })) {
+                throw std::runtime_error("Failed to create worker wakeup fd");
+            }
+
+            if (options_.trace_capacity > 0) {
+                recorder_ = std::make_unique<trace::FlightRecorder>(
+                        static_cast<uint16_t>(options_.pool_shard), options_.trace_capacity);
+            }
+            thread_pool_->set_cpu_affinity(options_.pool_cpus);
+            if (options_.metrics) register_metrics(*options_.metrics);
         }
 
-        Worker::~Worker() { stop(); }
+        void Worker::register_metrics(metrics::Registry& registry) {
+            const metrics::Labels labels = {{"worker", std::to_string(options_.pool_shard)}};
+            connection_metrics_.requests = &registry.counter("eventcore_http_requests_total",
+                    "Requests answered by a handler", labels);
+            connection_metrics_.rejected_requests = &registry.counter("eventcore_http_rejected_requests_total",
+                    "Malformed or oversized requests rejected by the parser", labels);
+            connection_metrics_.bytes_received = &registry.counter("eventcore_bytes_received_total",
+                    "Bytes read from client sockets", labels);
+            connection_metrics_.bytes_sent = &registry.counter("eventcore_bytes_sent_total",
+                    "Bytes written to client sockets", labels);
+            // Stage latencies are merged across workers, so they carry no worker label
+            connection_metrics_.parse_latency = &registry.latency("eventcore_stage_seconds",
+                    "Latency by processing stage and route", {{"stage", "parse"}, {"route", "*"}});
+            connection_metrics_.write_latency = &registry.latency("eventcore_stage_seconds",
+                    "Latency by processing stage and route", {{"stage", "write"}, {"route", "*"}});
+            poll_events_ = &registry.counter("eventcore_worker_poll_events_total",
+                    "Readiness events returned by the worker's poller", labels);
+            idle_closes_ = &registry.counter("eventcore_worker_idle_closes_total",
+                    "Keep-alive connections closed for being idle", labels);
+
+            loop_iteration_ = &registry.latency("eventcore_loop_iteration_seconds",
+                    "Event loop time from waking up with events to the next poll", labels);
+            events_per_poll_ = &registry.histogram("eventcore_loop_events_per_poll",
+                    "Events returned by polls that returned any", {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024},
+                    1.0, labels);
+            readiness_lag_ = &registry.latency("eventcore_loop_readiness_lag_seconds",
+                    "Time from a connection being reported ready to a pool thread handling it", labels);
+            stalls_ = &registry.counter("eventcore_loop_stalls_total",
+                    "Loop iterations or readiness handoffs slower than the stall threshold", labels);
+            const net::Poller* poller = poller_.get();
+            registry.counter_fn("eventcore_poller_saturated_total",
+                    "Polls that filled the whole event array", labels,
+                    [poller]() { return static_cast<double>(poller->stats().saturated_polls); });
+            registry.gauge_fn("eventcore_poller_event_capacity", "Events one poll can return", labels,
+                    [poller]() { return static_cast<double>(poller->stats().event_capacity); });
+
+            const ConnectionPool::Shard* shard = shard_;
+            registry.gauge_fn("eventcore_connections_active", "Open client connections", labels,
+                    [shard]() { return static_cast<double>(shard->active()); });
+            thread_pool_->register_metrics(registry, labels);
+        }
+
+        Worker::~Worker() {
+            stop();
+            if (wakeup_fd_ >= 0) {
+                poller_->remove(wakeup_fd_);
+                ::close(wakeup_fd_);
+            }
+#ifndef __linux__
+            if (wakeup_write_fd_ >= 0) ::close(wakeup_write_fd_);
+#endif
+        }
+
+        void Worker::register_route_metrics(metrics::Registry& registry) {
+            for (size_t id = 0; id < router_->num_routes(); ++id) {
+                handler_latency_.push_back(&registry.latency("eventcore_stage_seconds",
+                            "Latency by processing stage and route",
+                            {{"stage", "handler"}, {"route", router_->route_pattern(id)}}));
+            }
+            handler_latency_.push_back(&registry.latency("eventcore_stage_seconds",
+                        "Latency by processing stage and route", {{"stage", "handler"}, {"route", "(other)"}}));
+            // Handlers are timed once, per route; the all-routes series merges those
+            registry.latency_view("eventcore_stage_seconds", "Latency by processing stage and route",
+                    {{"stage", "handler"}, {"route", "*"}},
+                    std::vector<const metrics::LatencyHistogram*>(handler_latency_.begin(), handler_latency_.end()));
+        }
+
+        http::Response Worker::handle_request(const http::Request& request) {
+            if (handler_latency_.empty()) return router_->route(request);
+
+            size_t route_id = http::Router::kNoRoute;
+            const auto start = std::chrono::steady_clock::now();
+            http::Response response = router_->route(request, &route_id);
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            metrics::LatencyHistogram* latency = route_id < handler_latency_.size() - 1
+                ? handler_latency_[route_id] : handler_latency_.back();
+            latency->record(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            return response;
+        }
 
         void Worker::start() {
             if (running_) return;
             running_ = true;
+            // Routes are registered after the server is constructed, so their
+            // histograms are created here, once.
+            if (options_.metrics && handler_latency_.empty()) register_route_metrics(*options_.metrics);
             thread_pool_->start();
             event_thread_ = std::thread(&Worker::event_loop, this);
             LOG_INFO("Worker started");
@@ -42,37 +155,133 @@ namespace eventcore {
             thread_pool_->stop();
 
             {
-                std::lock_guard<std::mutex> lock(mutex_);
-                connections_.clear();
+                // Sockets handed over after the loop's last wakeup were never registered
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                for (int fd : pending_fds_) ::close(fd);
+                pending_fds_.clear();
+                pending_releases_.clear();
+            }
+
+            // The loop and pool threads are gone, so this thread now owns the shard
+            for (size_t slot = 0; slot < shard_->capacity(); ++slot) {
+                release_connection(static_cast<uint32_t>(slot));
+            }
+
+            if (options_.busy_poll) {
+                LoopStats stats = loop_stats();
+                LOG_INFO("Worker busy-poll: spin ", stats.spin_ns / 1000000, " ms, work ",
+                        stats.work_ns / 1000000, " ms, hits ", stats.spin_hits,
+                        ", misses ", stats.spin_misses);
             }
 
             LOG_INFO("Worker stopped");
         }
 
-        void Worker::add_connection(http::ConnectionPtr conn) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            int fd = conn->fd();
-            connections_[fd] = conn;
+        LoopStats Worker::loop_stats() const {
+            LoopStats stats;
+            stats.spin_ns = spin_ns_.load(std::memory_order_relaxed);
+            stats.work_ns = work_ns_.load(std::memory_order_relaxed);
+            stats.spin_hits = spin_hits_.load(std::memory_order_relaxed);
+            stats.spin_misses = spin_misses_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        void Worker::add_connection(net::Socket socket) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                pending_fds_.push_back(socket.release());
+            }
 
-            conn->set_close_callback([this](http::ConnectionPtr conn) {
-                    remove_connection(conn->fd());
-                    pool_->release(conn->fd());
-                    });
+            uint64_t one = 1;
+#ifdef __linux__
+            ssize_t n = ::write(wakeup_fd_, &one, sizeof(one));
+#else
+            ssize_t n = ::write(wakeup_write_fd_, &one, 1);
+#endif
+            (void)n;  // A full eventfd counter still leaves the loop woken
+        }
+
+        void Worker::post_release(uint32_t slot) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                pending_releases_.push_back(slot);
+            }
+
+            uint64_t one = 1;
+#ifdef __linux__
+            ssize_t n = ::write(wakeup_fd_, &one, sizeof(one));
+#else
+            ssize_t n = ::write(wakeup_write_fd_, &one, 1);
+#endif
+            (void)n;
+        }
+
+        void Worker::handle_wakeup() {
+            uint64_t count;
+            while (::read(wakeup_fd_, &count, sizeof(count)) > 0) {}
+
+            std::vector<int> fds;
+            std::vector<uint32_t> releases;
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                fds.swap(pending_fds_);
+                releases.swap(pending_releases_);
+            }
+
+            // Free slots first so the new sockets can reuse them
+            for (uint32_t slot : releases) {
+                release_connection(slot);
+            }
+            for (int fd : fds) {
+                register_connection(fd);
+            }
+
+            poller_->modify(wakeup_fd_, net::Poller::kReadable);
+        }
+
+        void Worker::register_connection(int fd) {
+            uint32_t slot = ConnectionPool::Shard::kNoSlot;
+            auto conn = shard_->acquire(fd, request_handler_, &slot);
+            if (!conn) {
+                LOG_WARN("Connection pool exhausted, rejecting connection");
+                ::close(fd);
+                return;
+            }
+            conn->set_buffer_pool(buffer_pool_);
+            conn->set_parser_limits(options_.parser_limits);
+            conn->set_metrics(options_.metrics ? &connection_metrics_ : nullptr);
+            if (recorder_) {
+                const uint64_t id = ++next_connection_id_;
+                conn->set_trace(recorder_.get(), id);
+                recorder_->record(trace::EventType::kAccept, id, static_cast<uint32_t>(fd));
+            }
+            // The socket stays open until release_connection() has unregistered it,
+            // so its fd number cannot be reused while this shard still maps it.
+            conn->set_deferred_close(true);
+
+            // Mark connected before registering: the poller may report readiness
+            // (data already queued on the socket) as soon as the fd is added.
+            conn->start();
 
             if (!poller_->add(
                         fd,
                         net::Poller::kReadable,
-                        [this](int fd, int events) {
-                        handle_connection_event(fd, events);
+                        [this, slot](int, int events) {
+                        handle_connection_event(slot, events);
                         })) 
             {
                 LOG_ERROR("Failed to add connection to poller");
-                connections_.erase(fd);
-                pool_->release(fd);
-                return;
+                conn->close_socket();
+                shard_->release(slot);
             }
+        }
 
-            conn->start();
+        void Worker::release_connection(uint32_t slot) {
+            if (!shard_->in_use(slot)) return;
+
+            poller_->remove(shard_->fd_of(slot));
+            shard_->connection(slot)->close_socket();
+            shard_->release(slot);
         }
 
         void Worker::check_idle_connections() {
@@ -85,79 +294,143 @@ namespace eventcore {
 
             last_timeout_check_ = now;
 
-            auto idle_fds = pool_->get_idle_connections(std::chrono::seconds(60));
-
-            for (int fd : idle_fds) {
-                std::lock_guard<std::mutex> lock(mutex_);
-                auto it = connections_.find(fd);
-                if (it != connections_.end()) {
-                    LOG_DEBUG("Closing idle connection: ", fd);
-                    poller_->remove(fd);
-                    close(fd);
-                    connections_.erase(it);
-                    pool_->release(fd);
+            for (size_t i = 0; i < shard_->capacity(); ++i) {
+                uint32_t slot = static_cast<uint32_t>(i);
+                if (!shard_->in_use(slot)) continue;
+
+                const auto& conn = shard_->connection(slot);
+                if (conn->is_open() && conn->is_idle(options_.idle_timeout)) {
+                    // The resulting EOF is handled like a peer close, on a pool thread
+                    LOG_DEBUG("Closing idle connection: ", shard_->fd_of(slot));
+                    if (idle_closes_) idle_closes_->inc();
+                    ::shutdown(shard_->fd_of(slot), SHUT_RDWR);
                 }
             }
         }
 
         void Worker::event_loop() {
+            if (options_.cpu >= 0 && !thread::pin_current_thread(options_.cpu)) {
+                LOG_WARN("Failed to pin worker event loop to CPU ", options_.cpu);
+            }
+            if (options_.numa_node >= 0 && !thread::prefer_memory_node(options_.numa_node)) {
+                LOG_DEBUG("NUMA memory policy not applied for node ", options_.numa_node);
+            }
+
             while (running_) {
                 try {
-                    int num_events = poller_->poll(100);
+                    int num_events = options_.busy_poll ? busy_poll() : poller_->poll(100);
 
                     if (num_events < 0 && errno != EINTR) {
                         LOG_ERROR("Poller error");
                         break;
                     }
+                    if (num_events > 0 && poll_events_) poll_events_->inc(static_cast<uint64_t>(num_events));
 
                     // Check for idle connections periodically
                     check_idle_connections();
 
+                    if (num_events > 0 && loop_iteration_) record_iteration(num_events);
+
                 } catch (const std::exception& e) {
                     LOG_ERROR("Exception in worker event loop: ", e.what());
                 }
             }
         }
 
-        void Worker::handle_connection_event(int fd, int events) {
-            std::lock_guard<std::mutex> lock(mutex_);
-
-            auto it = connections_.find(fd);
-            if (it == connections_.end()) return;
+        // Spins on zero-timeout polls until events show up or the budget runs out,
+        // then falls back to a blocking poll so an idle worker does not burn its core.
+        int Worker::busy_poll() {
+            using clock = std::chrono::steady_clock;
+            const auto deadline = clock::now() + options_.busy_poll_budget;
+            uint64_t spin_ns = 0;
 
-            auto conn = it->second;
-
-            try {
-                if (events & net::Poller::kError) {
-                    remove_connection(fd);
-                    pool_->release(fd);
-                    return;
+            while (running_) {
+                auto t0 = clock::now();
+                int num_events = poller_->poll(0);
+                auto t1 = clock::now();
+                auto elapsed = static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+                if (num_events != 0) {
+                    spin_ns_.fetch_add(spin_ns, std::memory_order_relaxed);
+                    if (num_events > 0) {
+                        work_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+                        spin_hits_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return num_events;
                 }
 
-                if (events & net::Poller::kReadable) {
-                    // Process in thread pool
-                    thread_pool_->submit([conn, this, fd]() {
-                            conn->handle_read();
-                            conn->update_activity();
-                            });
-                }
+                spin_ns += elapsed;
+                if (t1 >= deadline) break;
+            }
 
-                if (events & net::Poller::kWritable) {
-                    thread_pool_->submit([conn]() {
-                            conn->handle_write();
-                            });
-                }
+            spin_ns_.fetch_add(spin_ns, std::memory_order_relaxed);
+            spin_misses_.fetch_add(1, std::memory_order_relaxed);
+            return poller_->poll(100);
+        }
+
+        void Worker::record_iteration(int num_events) {
+            const auto elapsed = std::chrono::steady_clock::now() - poller_->ready_time();
+            loop_iteration_->record(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            events_per_poll_->observe(static_cast<uint64_t>(num_events));
+            check_stall("event loop iteration", elapsed);
+        }
 
-            } catch (const std::exception& e) {
-                LOG_ERROR("Error handling connection event: ", e.what());
-                remove_connection(fd);
-                pool_->release(fd);
+        void Worker::check_stall(const char* what, std::chrono::steady_clock::duration delay) {
+            if (options_.stall_threshold.count() <= 0 || delay < options_.stall_threshold) return;
+            stalls_->inc();
+
+            const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            auto last = last_stall_log_.load(std::memory_order_relaxed);
+            const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::seconds(1)).count();
+            if (now - last >= interval && last_stall_log_.compare_exchange_strong(last, now)) {
+                LOG_WARN("Worker ", options_.pool_shard, " stalled: ", what, " took ",
+                        std::chrono::duration_cast<std::chrono::milliseconds>(delay).count(), " ms");
             }
         }
 
-        void Worker::remove_connection(int fd) {
-            poller_->remove(fd);
-            connections_.erase(fd);
+        void Worker::handle_connection_event(uint32_t slot, int events) {
+            if (!shard_->in_use(slot)) return;
+
+            http::ConnectionPtr conn = shard_->connection(slot);
+            int fd = shard_->fd_of(slot);
+
+            // Errors and hang-ups surface as a failed or empty read, so every event
+            // goes through handle_read. Only this task may release the slot, which
+            // keeps the Connection from being reused while it is still running.
+            if (events & (net::Poller::kReadable | net::Poller::kWritable | net::Poller::kError)) {
+                const auto ready = poller_->ready_time();
+                thread_pool_->submit([conn, this, fd, slot, events, ready]() {
+                        if (readiness_lag_) {
+                            const auto lag = std::chrono::steady_clock::now() - ready;
+                            readiness_lag_->record(static_cast<uint64_t>(
+                                        std::chrono::duration_cast<std::chrono::nanoseconds>(lag).count()));
+                            check_stall("readiness handoff", lag);
+                        }
+                        try {
+                            // Flush the backlog first so reading can resume below it
+                            if (events & (net::Poller::kWritable | net::Poller::kError)) conn->handle_write();
+                            conn->handle_read();
+                        } catch (const std::exception& e) {
+                            LOG_ERROR("Error handling connection event: ", e.what());
+                            conn->force_close();
+                        }
+
+                        int interest = 0;
+                        if (conn->wants_read()) interest |= net::Poller::kReadable;
+                        if (conn->wants_write()) interest |= net::Poller::kWritable;
+                        if (interest != 0) {
+                            conn->update_activity();
+                            // Re-arm the one-shot registration for the next request,
+                            // or for the rest of the queued output.
+                            poller_->modify(fd, interest);
+                        } else {
+                            post_release(slot);
+                        }
+                        });
+            }
         }
 
     } // namespace server
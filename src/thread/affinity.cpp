@@ -0,0 +1,209 @@
+#include "eventcore/thread/affinity.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace eventcore {
+    namespace thread {
+
+        namespace {
+
+            constexpr const char* kCpuRoot = "/sys/devices/system/cpu/";
+            constexpr const char* kNodeRoot = "/sys/devices/system/node/";
+            constexpr int kMpolPreferred = 1;  // MPOL_PREFERRED from <linux/mempolicy.h>
+
+            bool read_int(const std::string& path, int* value) {
+                std::ifstream in(path);
+                return static_cast<bool>(in >> *value);
+            }
+
+            // Parses the kernel's cpulist format, e.g. "0-3,8,10-11".
+            std::vector<int> parse_cpulist(const std::string& list) {
+                std::vector<int> cpus;
+                std::stringstream ss(list);
+                std::string range;
+                while (std::getline(ss, range, ',')) {
+                    if (range.empty()) continue;
+                    size_t dash = range.find('-');
+                    try {
+                        int first = std::stoi(range.substr(0, dash));
+                        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+                    } catch (const std::exception&) {
+                        return {};
+                    }
+                }
+                return cpus;
+            }
+
+            std::vector<int> allowed_cpus() {
+                std::vector<int> cpus;
+#ifdef __linux__
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                        if (CPU_ISSET(static_cast<size_t>(cpu), &set)) cpus.push_back(cpu);
+                    }
+                }
+#endif
+                if (cpus.empty()) {
+                    unsigned n = std::thread::hardware_concurrency();
+                    for (unsigned cpu = 0; cpu < std::max(n, 1u); ++cpu) cpus.push_back(static_cast<int>(cpu));
+                }
+                return cpus;
+            }
+
+        } // namespace
+
+        CpuTopology CpuTopology::detect() {
+            CpuTopology topology;
+
+            for (int cpu : allowed_cpus()) {
+                CpuInfo info;
+                info.cpu = cpu;
+                info.core_id = cpu;
+                const std::string dir = std::string(kCpuRoot) + "cpu" + std::to_string(cpu) + "/topology/";
+                read_int(dir + "core_id", &info.core_id);
+                read_int(dir + "physical_package_id", &info.package_id);
+                topology.cpus_.push_back(info);
+            }
+
+#ifdef __linux__
+            if (DIR* dir = opendir(kNodeRoot)) {
+                while (struct dirent* entry = readdir(dir)) {
+                    std::string name = entry->d_name;
+                    if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                            !std::isdigit(static_cast<unsigned char>(name[4]))) {
+                        continue;
+                    }
+                    int node = std::atoi(name.c_str() + 4);
+                    std::ifstream in(std::string(kNodeRoot) + name + "/cpulist");
+                    std::string list;
+                    std::getline(in, list);
+                    for (int cpu : parse_cpulist(list)) {
+                        for (auto& info : topology.cpus_) {
+                            if (info.cpu == cpu) info.node = node;
+                        }
+                    }
+                }
+                closedir(dir);
+            }
+#endif
+            return topology;
+        }
+
+        std::vector<int> CpuTopology::logical_cpus() const {
+            std::vector<int> result;
+            for (const auto& info : cpus_) result.push_back(info.cpu);
+            return result;
+        }
+
+        std::vector<int> CpuTopology::physical_cores() const {
+            std::vector<int> result;
+            for (size_t i = 0; i < cpus_.size(); ++i) {
+                bool first_on_core = true;
+                for (size_t j = 0; j < i; ++j) {
+                    if (cpus_[j].core_id == cpus_[i].core_id && cpus_[j].package_id == cpus_[i].package_id) {
+                        first_on_core = false;
+                        break;
+                    }
+                }
+                if (first_on_core) result.push_back(cpus_[i].cpu);
+            }
+            return result;
+        }
+
+        std::vector<int> CpuTopology::siblings_of(int cpu) const {
+            std::vector<int> result;
+            auto self = std::find_if(cpus_.begin(), cpus_.end(),
+                    [cpu](const CpuInfo& info) { return info.cpu == cpu; });
+            if (self == cpus_.end()) return result;
+
+            for (const auto& info : cpus_) {
+                if (info.cpu != cpu && info.core_id == self->core_id && info.package_id == self->package_id) {
+                    result.push_back(info.cpu);
+                }
+            }
+            return result;
+        }
+
+        std::vector<int> CpuTopology::cpus_on_node(int node) const {
+            std::vector<int> result;
+            for (const auto& info : cpus_) {
+                if (info.node == node) result.push_back(info.cpu);
+            }
+            return result;
+        }
+
+        int CpuTopology::node_of(int cpu) const {
+            for (const auto& info : cpus_) {
+                if (info.cpu == cpu) return info.node;
+            }
+            return 0;
+        }
+
+        size_t CpuTopology::num_nodes() const {
+            int max_node = 0;
+            for (const auto& info : cpus_) max_node = std::max(max_node, info.node);
+            return static_cast<size_t>(max_node) + 1;
+        }
+
+        size_t available_cpu_count() {
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                int count = CPU_COUNT(&set);
+                if (count > 0) return static_cast<size_t>(count);
+            }
+#endif
+            size_t n = std::thread::hardware_concurrency();
+            return n == 0 ? 1 : n;
+        }
+
+        bool pin_current_thread(int cpu) {
+            return pin_current_thread(std::vector<int>{cpu});
+        }
+
+        bool pin_current_thread(const std::vector<int>& cpus) {
+#ifdef __linux__
+            if (cpus.empty()) return false;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+                CPU_SET(static_cast<size_t>(cpu), &set);
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            (void)cpus;
+            return false;
+#endif
+        }
+
+        bool prefer_memory_node(int node) {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+            if (node < 0 || node >= static_cast<int>(sizeof(unsigned long) * 8)) return false;
+            unsigned long nodemask = 1UL << node;
+            return syscall(SYS_set_mempolicy, kMpolPreferred, &nodemask, sizeof(nodemask) * 8) == 0;
+#else
+            (void)node;
+            return false;
+#endif
+        }
+
+    } // namespace thread
+} // namespace eventcore
@@ -1,4 +1,5 @@
 #include "eventcore/thread/thread_pool.h"
+#include "eventcore/thread/affinity.h"
 #include "eventcore/core/logger.h"
 #include <algorithm>
 #include <sstream>
@@ -30,34 +31,60 @@ namespace eventcore {
             if (!running_) return;
             running_ = false;
 
-            // Wake up all threads
-            for (size_t i = 0; i < threads_.size(); ++i) {
-                submit([]{}); 
-            }
+            // Wake up all threads; tasks already queued are still run before they exit
+            tasks_.stop();
 
             // Join all threads
             for (auto& thread : threads_) {
                 if (thread.joinable()) thread.join();
             }
             threads_.clear(); 
+            tasks_.restart();
 
             LOG_INFO("ThreadPool stopped");
         }
 
         void ThreadPool::submit(Task task) { 
-            tasks_.push(std::move(task)); 
+            QueuedTask queued{std::move(task), {}};
+            if (queue_wait_) queued.enqueued = std::chrono::steady_clock::now();
+            tasks_.push(std::move(queued));
+        }
+
+        void ThreadPool::register_metrics(metrics::Registry& registry, const metrics::Labels& labels) {
+            tasks_completed_ = &registry.counter("eventcore_thread_pool_tasks_total",
+                    "Tasks run by the thread pool", labels);
+            registry.gauge_fn("eventcore_thread_pool_queue_depth", "Tasks waiting for a pool thread", labels,
+                    [this]() { return static_cast<double>(pending_tasks()); });
+            // Not labelled per pool: every pool's waits merge into one series
+            queue_wait_ = &registry.latency("eventcore_stage_seconds", "Latency by processing stage and route",
+                    {{"stage", "queue_wait"}, {"route", "*"}});
         }
 
         void ThreadPool::worker_thread() {
-            while (running_) {
+            if (!cpu_affinity_.empty() && !pin_current_thread(cpu_affinity_)) {
+                LOG_WARN("Failed to apply ThreadPool CPU affinity");
+            }
+
+            while (true) {
+                QueuedTask queued;
+                try {
+                    queued = tasks_.pop();
+                } catch (const std::runtime_error&) {
+                    break;  // Stopped and drained
+                }
+
+                if (queue_wait_) {
+                    queue_wait_->record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - queued.enqueued).count()));
+                }
                 try {
-                    Task task = tasks_.pop();
-                    if (task) task();
+                    if (queued.task) queued.task();
                 } catch (const std::exception& e) {
                     std::stringstream ss;
                     ss << "Exception in worker thread: " << e.what();
                     LOG_ERROR(ss.str());
                 }
+                if (tasks_completed_) tasks_completed_->inc();
             }
         }
 
@@ -0,0 +1,36 @@
+// Converts a flight recorder dump (Server::dump_trace, the trace dump signal
+// or the trace route) to Chrome trace-event JSON for chrome://tracing or
+// https://ui.perfetto.dev.
+#include "eventcore/core/trace.h"
+#include <cstdio>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " TRACE.bin [OUT.json]\n"
+            << "Writes to stdout when OUT.json is omitted." << std::endl;
+        return 2;
+    }
+
+    auto events = eventcore::trace::read_file(argv[1]);
+    if (events.is_err()) {
+        std::cerr << argv[1] << ": " << events.error() << std::endl;
+        return 1;
+    }
+    const std::string json = eventcore::trace::to_chrome_json(events.value());
+
+    FILE* out = argc == 3 ? std::fopen(argv[2], "w") : stdout;
+    if (!out) {
+        std::perror(argv[2]);
+        return 1;
+    }
+    const bool written = std::fwrite(json.data(), 1, json.size(), out) == json.size();
+    if ((out != stdout && std::fclose(out) != 0) || !written) {
+        std::cerr << "Failed to write JSON" << std::endl;
+        return 1;
+    }
+    if (argc == 3) {
+        std::cerr << events.value().size() << " events written to " << argv[2] << std::endl;
+    }
+    return 0;
+}
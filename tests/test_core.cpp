@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "eventcore/core/metrics.h"
+#include "eventcore/core/trace.h"
+#include "eventcore/thread/thread_pool.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using eventcore::thread::ThreadPool;
+
+TEST(MetricsTest, ShardedRecordingAggregatesOnScrape) {
+    eventcore::metrics::Registry registry;
+    auto& counter = registry.counter("test_events_total", "Events", {{"kind", "a"}});
+    auto& latency = registry.histogram("test_latency_seconds", "Latency", {1000, 1000000}, 1e-9);
+    EXPECT_EQ(&counter, &registry.counter("test_events_total", "Events", {{"kind", "a"}}));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+                for (int i = 0; i < 1000; ++i) {
+                    counter.inc();
+                    latency.observe(static_cast<uint64_t>(i) * 1000);
+                }
+                });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(counter.value(), 4000u);
+
+    auto snap = latency.snapshot();
+    EXPECT_EQ(snap.count, 4000u);
+    EXPECT_EQ(snap.counts[0], 8u);     // 0 and 1000 ns
+    EXPECT_EQ(snap.counts[2], 0u);     // Nothing above 1 ms
+
+    ThreadPool pool(2);
+    pool.register_metrics(registry, {{"pool", "test"}});
+    pool.start();
+    std::atomic<int> done{0};
+    for (int i = 0; i < 10; ++i) pool.submit([&done]() { done++; });
+    while (done < 10) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pool.stop();
+
+    const std::string text = registry.render();
+    EXPECT_NE(text.find("# TYPE test_events_total counter\ntest_events_total{kind=\"a\"} 4000\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"1e-06\"} 8\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"+Inf\"} 4000\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_count 4000\n"), std::string::npos);
+    EXPECT_NE(text.find("eventcore_thread_pool_tasks_total{pool=\"test\"} 10\n"), std::string::npos);
+    EXPECT_NE(text.find("eventcore_thread_pool_queue_depth{pool=\"test\"} 0\n"), std::string::npos);
+}
+
+TEST(MetricsTest, LatencyHistogramQuantilesMergeAcrossWriters) {
+    using eventcore::metrics::LatencyHistogram;
+    size_t last = 0;
+    for (uint64_t v = 0; v < (uint64_t(1) << 30); v = v < 200 ? v + 1 : v + v / 7) {
+        const size_t bucket = LatencyHistogram::bucket_of(v);
+        ASSERT_LT(bucket, LatencyHistogram::kBuckets);
+        ASSERT_GE(bucket, last);
+        const uint64_t upper = LatencyHistogram::bucket_upper(bucket);
+        ASSERT_GE(upper, v);
+        ASSERT_LE(static_cast<double>(upper - v), static_cast<double>(v) / 32.0);
+        last = bucket;
+    }
+    EXPECT_EQ(LatencyHistogram::bucket_of(UINT64_MAX), LatencyHistogram::kBuckets - 1);
+
+    eventcore::metrics::Registry registry;
+    auto& even = registry.latency("test_stage_seconds", "Stage", {{"stage", "handler"}});
+    auto& odd = registry.latency("test_stage_seconds", "Stage", {{"stage", "handler"}});
+    EXPECT_NE(&even, &odd);
+    std::thread writer([&]() { for (uint64_t v = 2; v <= 100000; v += 2) even.record(v); });
+    for (uint64_t v = 1; v <= 100000; v += 2) odd.record(v);
+    writer.join();
+
+    registry.latency_view("test_stage_seconds", "Stage", {{"stage", "all"}}, {&even, &odd});
+
+    LatencyHistogram::Snapshot merged = even.snapshot();
+    merged.merge(odd.snapshot());
+    EXPECT_EQ(merged.count, 100000u);
+    EXPECT_NEAR(static_cast<double>(merged.quantile(0.5)), 50000.0, 50000.0 * 0.035);
+    EXPECT_NEAR(static_cast<double>(merged.quantile(0.99)), 99000.0, 99000.0 * 0.035);
+    EXPECT_NEAR(static_cast<double>(merged.quantile(0.999)), 99900.0, 99900.0 * 0.035);
+
+    const std::string text = registry.render();
+    EXPECT_NE(text.find("# TYPE test_stage_seconds summary\n"), std::string::npos);
+    EXPECT_NE(text.find("test_stage_seconds{stage=\"handler\",quantile=\"0.999\"}"), std::string::npos);
+    EXPECT_NE(text.find("test_stage_seconds_count{stage=\"handler\"} 100000\n"), std::string::npos);
+    EXPECT_NE(text.find("test_stage_seconds_count{stage=\"all\"} 100000\n"), std::string::npos);
+}
+
+TEST(FlightRecorderTest, KeepsNewestEventsFromConcurrentWriters) {
+    using namespace eventcore::trace;
+    FlightRecorder recorder(3, 1000);
+    EXPECT_EQ(recorder.capacity(), 1024u);
+
+    // Each writer tags its events with its own connection id and a running
+    // count, so a torn or reordered slot would show up below.
+    constexpr uint32_t kPerThread = 5000;
+    std::vector<std::thread> writers;
+    for (uint64_t t = 0; t < 4; ++t) {
+        writers.emplace_back([&recorder, t]() {
+                for (uint32_t i = 0; i < kPerThread; ++i) {
+                    recorder.record(EventType::kHandlerEnd, t, i);
+                }
+                });
+    }
+    for (auto& writer : writers) writer.join();
+
+    EXPECT_EQ(recorder.recorded(), 4u * kPerThread);
+    std::vector<Event> events = recorder.snapshot();
+    ASSERT_EQ(events.size(), recorder.capacity());
+    uint32_t last[4] = {0, 0, 0, 0};
+    bool seen[4] = {false, false, false, false};
+    for (const Event& event : events) {
+        ASSERT_LT(event.connection, 4u);
+        EXPECT_EQ(event.worker, 3);
+        EXPECT_EQ(event.type, EventType::kHandlerEnd);
+        if (seen[event.connection]) EXPECT_GT(event.arg, last[event.connection]);
+        last[event.connection] = event.arg;
+        seen[event.connection] = true;
+    }
+    // Oldest first, so the ring ends with the final event of whichever writer finished last
+    EXPECT_EQ(events.back().arg, kPerThread - 1);
+
+    auto restored = deserialize(serialize(events));
+    ASSERT_TRUE(restored.is_ok());
+    ASSERT_EQ(restored.value().size(), events.size());
+    EXPECT_EQ(restored.value().back().arg, events.back().arg);
+    EXPECT_TRUE(deserialize("ECTRACE1").is_err());
+
+    const std::string json = to_chrome_json(events);
+    EXPECT_EQ(json.compare(0, 17, "{\"displayTimeUnit"), 0);
+    EXPECT_NE(json.find("{\"name\":\"handler\",\"ph\":\"E\",\"pid\":3,\"tid\":"), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"status\":4999}"), std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
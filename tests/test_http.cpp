@@ -1,7 +1,19 @@
 #include <gtest/gtest.h>
+#include "eventcore/core/alloc_counter.h"
 #include "eventcore/http/request.h"
 #include "eventcore/http/response.h"
 #include "eventcore/http/router.h"
+#include "eventcore/http/connection.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <vector>
 
 using namespace eventcore::http;
 
@@ -13,6 +25,143 @@ TEST(HttpRequestTest, MethodConversion) {
     EXPECT_EQ(Request::method_to_string(Method::POST), "POST");
 }
 
+TEST(HttpRequestTest, HeaderArenaIsReusedAfterReset) {
+    Request req;
+    req.set_header("Host", "localhost");
+    req.set_header("User-Agent", std::string(300, 'u'));
+    req.set_header("Host", "example.com");
+    EXPECT_EQ(req.headers().size(), 2u);
+    EXPECT_EQ(req.get_header("Host"), "example.com");
+    EXPECT_FALSE(req.has_header("Accept"));
+
+    Request copy = req;
+    const size_t reserved = req.headers().arena().reserved_bytes();
+    req.reset();
+    EXPECT_TRUE(req.headers().empty());
+    EXPECT_EQ(copy.get_header("User-Agent"), std::string(300, 'u'));
+
+    for (int i = 0; i < 3; ++i) {
+        req.set_header("User-Agent", std::string(300, 'v'));
+        req.reset();
+    }
+    EXPECT_EQ(req.headers().arena().reserved_bytes(), reserved);
+    EXPECT_EQ(req.headers().arena().num_blocks(), 1u);
+}
+
+TEST(HttpHeadersTest, KnownHeadersAreInternedCaseInsensitively) {
+    for (size_t i = 0; i < kNumKnownHeaders; ++i) {
+        const HeaderId id = static_cast<HeaderId>(i);
+        std::string name = header_name(id);
+        EXPECT_EQ(lookup_header(name.data(), name.size()), id) << name;
+        for (auto& c : name) c = static_cast<char>(tolower(c));
+        EXPECT_EQ(lookup_header(name.data(), name.size()), id) << name;
+    }
+    EXPECT_EQ(lookup_header("X-Request-Id", 12), HeaderId::kUnknown);
+    EXPECT_EQ(lookup_header("Hosts", 5), HeaderId::kUnknown);
+
+    Request req;
+    req.set_header("content-type", "text/plain");
+    req.set_header("X-Trace", "1");
+    req.set_header("CONTENT-TYPE", "application/json");
+    req.set_header("x-trace", "2");
+    EXPECT_EQ(req.headers().size(), 2u);
+    ASSERT_NE(req.header(HeaderId::kContentType), nullptr);
+    EXPECT_EQ(req.header(HeaderId::kContentType)->value_string(), "application/json");
+    EXPECT_EQ(req.get_header("Content-Type"), "application/json");
+    EXPECT_EQ(req.get_header("X-TRACE"), "2");
+    EXPECT_EQ(req.header(HeaderId::kHost), nullptr);
+}
+
+TEST(HttpParserTest, RejectsRequestsBeyondLimits) {
+    ParserLimits limits;
+    limits.max_request_line = 64;
+    limits.max_header_count = 4;
+    limits.max_header_bytes = 256;
+    limits.max_body_size = 100;
+
+    auto status_for = [&](const std::string& input) {
+        eventcore::net::Buffer buffer;
+        buffer.append(input);
+        Request request;
+        Parser parser(limits);
+        if (parser.parse_request(&buffer, &request)) return 200;
+        return parser.has_error() ? parser.error_status() : 0;
+    };
+
+    EXPECT_EQ(status_for("GET / HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"), 200);
+    EXPECT_EQ(status_for("GET / HTTP/1.1\r\nHost: x"), 0);
+    EXPECT_EQ(status_for("GET /" + std::string(100, 'a') + " HTTP/1.1\r\n\r\n"), 414);
+    EXPECT_EQ(status_for("GET /" + std::string(100, 'a')), 414);
+    EXPECT_EQ(status_for("GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\nD: 4\r\nE: 5\r\n\r\n"), 431);
+    EXPECT_EQ(status_for("GET / HTTP/1.1\r\nX-Big: " + std::string(300, 'b')), 431);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\ncontent-length: 101\r\n\r\n"), 413);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n"), 413);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n"), 400);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nno colon here\r\n\r\n"), 400);
+    EXPECT_EQ(status_for("BREW / HTTP/1.1\r\n\r\n"), 400);
+}
+
+TEST(HttpParserTest, RejectsAmbiguousBodyFraming) {
+    auto status_for = [](const std::string& input) {
+        eventcore::net::Buffer buffer;
+        buffer.append(input);
+        Request request;
+        Parser parser;
+        if (parser.parse_request(&buffer, &request)) return 200;
+        return parser.has_error() ? parser.error_status() : 0;
+    };
+
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 3\r\n\r\nabc"), 200);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length: 3\r\ncontent-length: 30\r\n\r\nabc"), 400);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length: 0\r\nContent-Length: 5\r\n\r\nGET /"), 400);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n"), 400);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length: 3\r\ntransfer-encoding: chunked\r\n\r\nabc"), 400);
+
+    // Whitespace or other non-token characters in the name must not hide a framing header
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nTransfer-Encoding : chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n"), 400);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nTransfer-Encoding\t: chunked\r\n\r\n"), 400);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length : 5\r\n\r\nhello"), 400);
+    EXPECT_EQ(status_for("POST / HTTP/1.1\r\nContent-Length\t: 5\r\n\r\nhello"), 400);
+    EXPECT_EQ(status_for("GET / HTTP/1.1\r\n Host: example.com\r\n\r\n"), 400);
+    EXPECT_EQ(status_for("GET / HTTP/1.1\r\nX(Y): 1\r\n\r\n"), 400);
+    EXPECT_EQ(status_for("GET / HTTP/1.1\r\nX-Custom_Header.v2~!: 1\r\n\r\n"), 200);
+
+    // A repeated Content-Length from an earlier request does not leak into the next
+    eventcore::net::Buffer buffer;
+    buffer.append("POST / HTTP/1.1\r\nContent-Length: 1\r\n\r\nx"
+            "POST / HTTP/1.1\r\nContent-Length: 2\r\n\r\nyz");
+    Request request;
+    Parser parser;
+    ASSERT_TRUE(parser.parse_request(&buffer, &request));
+    request.reset();
+    parser.reset();
+    ASSERT_TRUE(parser.parse_request(&buffer, &request));
+    EXPECT_EQ(request.body(), "yz");
+}
+
+TEST(HttpParserTest, ReusedParserDoesNotAllocate) {
+    if (!eventcore::alloc::counting_enabled()) {
+        GTEST_SKIP() << "Configure with -DEVENTCORE_ALLOC_COUNTING=ON to count allocations";
+    }
+    const std::string input =
+        "POST /api/items?page=2 HTTP/1.1\r\nHost: localhost\r\nUser-Agent: test\r\n"
+        "Content-Type: application/json\r\nContent-Length: 13\r\n\r\n{\"id\": 12345}";
+    eventcore::net::Buffer buffer;
+    Request request;
+    Parser parser;
+    auto parse_once = [&] {
+        buffer.append(input);
+        ASSERT_TRUE(parser.parse_request(&buffer, &request));
+        request.reset();
+        parser.reset();
+    };
+    parse_once();  // Grows the buffer, the header arena and the strings
+
+    eventcore::alloc::Scope scope;
+    for (int i = 0; i < 100; ++i) parse_once();
+    EXPECT_EQ(scope.delta().allocations, 0u);
+}
+
 TEST(HttpResponseTest, BasicCreation) {
     Response resp;
     resp.set_status(200, "OK");
@@ -42,6 +191,281 @@ TEST(HttpRouterTest, NotFound) {
     EXPECT_EQ(resp.status_code(), 404);
 }
 
+TEST(HttpConnectionTest, IdleKeepAliveConnectionHoldsNoBuffers) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    eventcore::net::SlabPool pool(1024);
+    auto conn = std::make_shared<Connection>(eventcore::net::Socket(fds[0]), [](const Request&) {
+            Response resp;
+            resp.set_body(std::string(5000, 'b'));
+            return resp;
+            });
+    conn->set_buffer_pool(&pool);
+    conn->start();
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ(write(fds[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+    conn->handle_read();
+
+    char buf[8192];
+    ssize_t n = read(fds[1], buf, sizeof(buf));
+    ASSERT_GT(n, 0);
+    EXPECT_EQ(std::string(buf, 15), "HTTP/1.1 200 OK");
+    EXPECT_TRUE(conn->is_connected());
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.bytes_in_use(), 0u);
+    EXPECT_GT(stats.bytes_cached(), 0u);
+
+    close(fds[1]);
+}
+
+TEST(HttpConnectionTest, RequestSplitAcrossReads) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    std::string seen_host;
+    auto conn = std::make_shared<Connection>(eventcore::net::Socket(fds[0]), [&](const Request& req) {
+            seen_host = req.get_header("Host");
+            Response resp;
+            resp.set_body("ok");
+            return resp;
+            });
+    conn->start();
+
+    const std::string first = "GET /split?x=1 HTTP/1.1\r\nHo";
+    const std::string second = "st: localhost\r\n\r\n";
+    ASSERT_EQ(write(fds[1], first.data(), first.size()), static_cast<ssize_t>(first.size()));
+    conn->handle_read();
+    ASSERT_EQ(write(fds[1], second.data(), second.size()), static_cast<ssize_t>(second.size()));
+    conn->handle_read();
+
+    char buf[512];
+    ssize_t n = read(fds[1], buf, sizeof(buf));
+    ASSERT_GT(n, 0);
+    const std::string response(buf, static_cast<size_t>(n));
+    EXPECT_EQ(response.substr(0, 15), "HTTP/1.1 200 OK");
+    EXPECT_NE(response.find("Connection: keep-alive\r\n"), std::string::npos);
+    EXPECT_EQ(seen_host, "localhost");
+
+    close(fds[1]);
+}
+
+TEST(HttpConnectionTest, LowercaseContentLengthFramesBody) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    std::vector<std::string> bodies;
+    auto conn = std::make_shared<Connection>(eventcore::net::Socket(fds[0]), [&](const Request& req) {
+            bodies.push_back(req.body());
+            return Response();
+            });
+    conn->start();
+
+    const std::string requests =
+        "POST /echo HTTP/1.1\r\nhost: localhost\r\ncontent-length: 5\r\n\r\nhello"
+        "GET / HTTP/1.1\r\nconnection: Close\r\n\r\n";
+    ASSERT_EQ(write(fds[1], requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+    conn->handle_read();
+
+    ASSERT_EQ(bodies.size(), 2u);
+    EXPECT_EQ(bodies[0], "hello");
+    EXPECT_EQ(bodies[1], "");
+    EXPECT_FALSE(conn->is_connected());
+
+    close(fds[1]);
+}
+
+TEST(HttpConnectionTest, PipelinedResponsesKeepOrder) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    auto conn = std::make_shared<Connection>(eventcore::net::Socket(fds[0]), [](const Request& req) {
+            Response resp;
+            resp.set_body(req.path());
+            return resp;
+            });
+    conn->start();
+
+    std::string requests;
+    for (const char* path : {"/a", "/b", "/c"}) {
+        requests += std::string("GET ") + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    }
+    ASSERT_EQ(write(fds[1], requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+    conn->handle_read();
+    EXPECT_FALSE(conn->wants_write());
+
+    char buf[1024];
+    ssize_t n = read(fds[1], buf, sizeof(buf));
+    ASSERT_GT(n, 0);
+    const std::string responses(buf, static_cast<size_t>(n));
+    const size_t a = responses.find("\r\n\r\n/a");
+    const size_t b = responses.find("\r\n\r\n/b");
+    const size_t c = responses.find("\r\n\r\n/c");
+    ASSERT_NE(c, std::string::npos);
+    EXPECT_LT(a, b);
+    EXPECT_LT(b, c);
+
+    close(fds[1]);
+}
+
+TEST(HttpConnectionTest, UnreadOutputPausesReading) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    const size_t body_size = Connection::kOutputHighWaterMark / 2 + 1;
+    int handled = 0;
+    auto conn = std::make_shared<Connection>(eventcore::net::Socket(fds[0]), [&](const Request&) {
+            ++handled;
+            Response resp;
+            resp.set_body(std::string(body_size, 'x'));
+            return resp;
+            });
+    conn->start();
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string requests;
+    for (int i = 0; i < 4; ++i) requests += request;
+    ASSERT_EQ(write(fds[1], requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+
+    // Parsing stops once unsent responses reach the high-water mark (what the
+    // socket accepted meanwhile no longer counts), and the backlog keeps the
+    // connection from reading further.
+    conn->handle_read();
+    EXPECT_LT(handled, 4);
+    EXPECT_TRUE(conn->wants_write());
+    EXPECT_FALSE(conn->wants_read());
+
+    // As the worker does on writability: flush, then resume the parked requests
+    size_t received = 0;
+    char buf[65536];
+    while (conn->wants_write()) {
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        if (n > 0) received += static_cast<size_t>(n);
+        conn->handle_write();
+        conn->handle_read();
+    }
+    EXPECT_EQ(handled, 4);
+    ssize_t n;
+    while ((n = read(fds[1], buf, sizeof(buf))) > 0) received += static_cast<size_t>(n);
+    EXPECT_GT(received, 4 * body_size);
+    EXPECT_TRUE(conn->wants_read());
+
+    close(fds[1]);
+}
+
+TEST(HttpConnectionTest, PipelinedBurstStaysNearOutputHighWaterMark) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    const size_t body_size = 256 * 1024;
+    const int num_requests = 32;
+    int handled = 0;
+    auto conn = std::make_shared<Connection>(eventcore::net::Socket(fds[0]), [&](const Request&) {
+            ++handled;
+            Response resp;
+            resp.set_body(std::string(body_size, 'x'));
+            return resp;
+            });
+    conn->start();
+
+    // 8 MB of responses asked for by one small read
+    std::string requests;
+    for (int i = 0; i < num_requests; ++i) requests += "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ(write(fds[1], requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+
+    const size_t bound = Connection::kOutputHighWaterMark + body_size + 1024;
+    conn->handle_read();
+    EXPECT_LT(handled, num_requests);
+    EXPECT_LE(conn->pending_output(), bound);
+
+    size_t received = 0;
+    char buf[65536];
+    while (handled < num_requests || conn->wants_write()) {
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        if (n > 0) received += static_cast<size_t>(n);
+        conn->handle_write();
+        conn->handle_read();
+        ASSERT_LE(conn->pending_output(), bound);
+    }
+    ssize_t n;
+    while ((n = read(fds[1], buf, sizeof(buf))) > 0) received += static_cast<size_t>(n);
+    EXPECT_EQ(handled, num_requests);
+    EXPECT_GT(received, num_requests * body_size);
+    EXPECT_TRUE(conn->wants_read());
+
+    close(fds[1]);
+}
+
+TEST(HttpConnectionTest, OversizedRequestIsRejectedAndClosed) {
+    // Over TCP, so closing with the client's body still unread would reset the
+    // connection instead of letting the client finish and read the 413
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    ASSERT_EQ(getsockname(listener, reinterpret_cast<struct sockaddr*>(&addr), &addr_len), 0);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(client, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(fcntl(client, F_SETFL, O_NONBLOCK), 0);
+    int server = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK);
+    ASSERT_GE(server, 0);
+    close(listener);
+
+    bool handled = false;
+    auto conn = std::make_shared<Connection>(eventcore::net::Socket(server), [&](const Request&) {
+            handled = true;
+            return Response();
+            });
+    ParserLimits limits;
+    limits.max_body_size = 16;
+    conn->set_parser_limits(limits);
+    conn->start();
+
+    const size_t body_size = 1000000;
+    const std::string request = "POST /upload HTTP/1.1\r\nContent-Length: 1000000\r\n\r\n";
+    ASSERT_EQ(send(client, request.data(), request.size(), MSG_NOSIGNAL), static_cast<ssize_t>(request.size()));
+    conn->handle_read();
+    EXPECT_TRUE(conn->is_open());
+
+    // The client sends its whole body before reading, as most clients do
+    const std::string chunk(16 * 1024, 'x');
+    for (size_t sent = 0; sent < body_size; conn->handle_read()) {
+        ssize_t n = send(client, chunk.data(), std::min(chunk.size(), body_size - sent), MSG_NOSIGNAL);
+        if (n > 0) sent += static_cast<size_t>(n);
+        else ASSERT_EQ(errno, EAGAIN) << "body write failed: " << std::strerror(errno);
+    }
+
+    std::string response;
+    char buf[512];
+    while (true) {
+        ssize_t n = recv(client, buf, sizeof(buf), 0);
+        if (n > 0) {
+            response.append(buf, static_cast<size_t>(n));
+        } else if (n == 0) {
+            break;
+        } else {
+            ASSERT_EQ(errno, EAGAIN) << "response read failed: " << std::strerror(errno);
+            conn->handle_read();
+        }
+    }
+    EXPECT_EQ(response.substr(0, 30), "HTTP/1.1 413 Payload Too Large");
+    EXPECT_NE(response.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_FALSE(handled);
+
+    // Closes once the client does
+    EXPECT_TRUE(conn->is_open());
+    close(client);
+    conn->handle_read();
+    EXPECT_FALSE(conn->is_open());
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
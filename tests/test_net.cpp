@@ -2,6 +2,13 @@
 #include "eventcore/net/socket.h"
 #include "eventcore/net/buffer.h"
 #include "eventcore/net/address.h"
+#include "eventcore/net/read_scratch.h"
+#include "eventcore/net/poller.h"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
 
 using namespace eventcore::net;
 
@@ -10,6 +17,42 @@ TEST(SocketTest, Creation) {
     EXPECT_TRUE(result.is_ok());
 }
 
+TEST(ResultTest, ErrnoErrorsAreStringifiedOnDemand) {
+    auto err = eventcore::Result<size_t>::Err(eventcore::Error::from_errno(EAGAIN, "send failed"));
+    EXPECT_TRUE(err.is_err());
+    EXPECT_TRUE(err.would_block());
+    EXPECT_EQ(err.error_code().category(), eventcore::ErrorCategory::kSystem);
+    EXPECT_EQ(err.error_code().code(), EAGAIN);
+    EXPECT_EQ(err.error(), std::string("send failed: ") + strerror(EAGAIN));
+
+    auto msg = eventcore::Result<void>::Err("bad input");
+    EXPECT_FALSE(msg.would_block());
+    EXPECT_EQ(msg.error(), "bad input");
+}
+
+TEST(ResultTest, StoresValueInline) {
+    auto ok = eventcore::Result<std::string>::Ok(std::string(64, 'x'));
+    ASSERT_TRUE(ok.is_ok());
+    auto moved = std::move(ok);
+    EXPECT_EQ(moved.value(), std::string(64, 'x'));
+    auto copy = moved;
+    EXPECT_EQ(copy.value(), moved.value());
+    copy = eventcore::Result<std::string>::Err("gone");
+    EXPECT_TRUE(copy.is_err());
+    EXPECT_EQ(copy.value_or("fallback"), "fallback");
+}
+
+TEST(ResultTest, WouldBlockFromNonBlockingAccept) {
+    auto sock = std::move(Socket::create_tcp().value());
+    ASSERT_TRUE(sock.bind(Address("127.0.0.1", 0)).is_ok());
+    ASSERT_TRUE(sock.listen().is_ok());
+    ASSERT_TRUE(sock.set_nonblocking().is_ok());
+
+    auto result = sock.accept(nullptr);
+    ASSERT_TRUE(result.is_err());
+    EXPECT_TRUE(result.would_block());
+}
+
 TEST(BufferTest, BasicOperations) {
     Buffer buf;
     buf.append("Hello");
@@ -18,12 +61,227 @@ TEST(BufferTest, BasicOperations) {
     EXPECT_EQ(str, "Hello");
 }
 
+TEST(BufferTest, ChainsSlabsWithoutMovingData) {
+    SlabPool pool(16);
+    Buffer buf(&pool);
+    const std::string request = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+    for (char c : request) buf.append(&c, 1);  // Small appends stay in the base class
+    EXPECT_EQ(buf.readable_bytes(), 37u);
+    EXPECT_EQ(buf.num_slabs(), 3u);
+    EXPECT_EQ(pool.in_use(), 3u);
+
+    // CRLF straddling a slab boundary is still found
+    EXPECT_EQ(buf.find_crlf(), 14u);
+    EXPECT_EQ(buf.find_crlf(16), 33u);
+    EXPECT_EQ(buf.find_crlf(36), Buffer::kNpos);
+
+    const char* line = buf.contiguous(14);
+    EXPECT_EQ(std::string(line, 14), "GET / HTTP/1.1");
+    buf.retrieve(16);
+
+    struct iovec iov[Buffer::kMaxIovecs];
+    size_t count = buf.peek_iovec(iov, Buffer::kMaxIovecs);
+    std::string gathered;
+    for (size_t i = 0; i < count; ++i) {
+        gathered.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    EXPECT_EQ(gathered, "Host: example.com\r\n\r\n");
+
+    buf.clear();
+    EXPECT_EQ(pool.in_use(), 0u);
+    EXPECT_GT(pool.cached(), 0u);
+}
+
+TEST(BufferTest, SliceSharesSlabs) {
+    SlabPool pool(64);
+    Buffer buf(&pool);
+    buf.append("header|body");
+
+    Buffer head = buf.slice(6);
+    EXPECT_EQ(pool.in_use(), 1u);
+
+    // The shared slab is read-only, so this lands in a new one
+    buf.append("!");
+    EXPECT_EQ(buf.num_slabs(), 2u);
+    EXPECT_EQ(head.retrieve_all_as_string(), "header");
+    EXPECT_EQ(buf.retrieve_all_as_string(), "|body!");
+}
+
+TEST(BufferTest, ReadAndWriteThroughFd) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    SlabPool pool(32);
+    Buffer out(&pool);
+    std::string payload(100, 'x');
+    out.append(payload);
+    EXPECT_EQ(out.write_to_fd(fds[1]), 100);
+    EXPECT_TRUE(out.empty());
+
+    Buffer in(&pool);
+    EXPECT_EQ(in.read_from_fd(fds[0]), 100);
+    EXPECT_EQ(in.retrieve_all_as_string(), payload);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(SlabPoolTest, SizeClassesAndOccupancy) {
+    SlabPool pool(1024, 8);
+    EXPECT_EQ(pool.max_slab_size(), 16384u);
+
+    Slab* small = pool.allocate();
+    Slab* medium = pool.allocate(3000);
+    Slab* huge = pool.allocate(100000);
+    EXPECT_EQ(small->capacity, 1024u);
+    EXPECT_EQ(medium->capacity, 4096u);
+    EXPECT_EQ(huge->capacity, 100000u);
+
+    SlabPoolStats stats = pool.stats();
+    EXPECT_EQ(stats.classes[0].in_use, 1u);
+    EXPECT_EQ(stats.classes[1].in_use, 1u);
+    EXPECT_EQ(stats.oversize_in_use, 1u);
+    EXPECT_EQ(stats.bytes_in_use(), 1024u + 4096u + 100000u);
+
+    SlabPool::release(small);
+    SlabPool::release(medium);
+    SlabPool::release(huge);
+    stats = pool.stats();
+    EXPECT_EQ(stats.bytes_in_use(), 0u);
+    EXPECT_EQ(stats.bytes_cached(), 1024u + 4096u);  // Oversize slabs are never cached
+
+    pool.trim();
+    EXPECT_EQ(pool.cached(), 0u);
+}
+
+TEST(BufferTest, LargeAppendUsesLargerClassAndShrinkReleases) {
+    SlabPool pool(1024);
+    Buffer buf(&pool);
+    buf.append(std::string(10000, 'z'));
+    EXPECT_EQ(buf.num_slabs(), 1u);
+    EXPECT_EQ(buf.capacity(), 16384u);
+
+    buf.retrieve_all();
+    EXPECT_EQ(pool.in_use(), 1u);  // Tail kept for the next append
+    buf.shrink();
+    EXPECT_EQ(pool.in_use(), 0u);
+}
+
+TEST(BufferTest, OverflowAdoptsScratchSlabs) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    SlabPool pool(1024);
+    Buffer in(&pool);
+    in.append("x", 1);  // Tail slab has 1023 bytes free
+
+    const ReadStats before = ReadScratch::stats();
+    std::string payload(5000, 'y');
+    ASSERT_EQ(write(fds[1], payload.data(), payload.size()), 5000);
+    EXPECT_EQ(in.read_from_fd(fds[0]), 5000);
+    EXPECT_EQ(in.readable_bytes(), 5001u);
+    EXPECT_EQ(in.num_slabs(), 5u);
+
+    const ReadStats after = ReadScratch::stats();
+    EXPECT_EQ(after.reads - before.reads, 1u);
+    EXPECT_EQ(after.overflow_reads - before.overflow_reads, 1u);
+    EXPECT_EQ(after.adopted_slabs - before.adopted_slabs, 4u);
+    EXPECT_EQ(in.retrieve_all_as_string(), "x" + payload);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
 TEST(AddressTest, Construction) {
     Address addr("127.0.0.1", 8080);
     EXPECT_EQ(addr.ip(), "127.0.0.1");
     EXPECT_EQ(addr.port(), 8080);
 }
 
+TEST(AddressTest, IPv6AndUnix) {
+    Address v6("::1", 8080);
+    EXPECT_TRUE(v6.is_ipv6());
+    EXPECT_EQ(v6.ip(), "::1");
+    EXPECT_EQ(v6.port(), 8080);
+    EXPECT_EQ(v6.to_string(), "[::1]:8080");
+    EXPECT_EQ(v6.socklen(), sizeof(struct sockaddr_in6));
+
+    Address un = Address::unix_path("/tmp/eventcore.sock").value();
+    EXPECT_TRUE(un.is_unix());
+    EXPECT_EQ(un.path(), "/tmp/eventcore.sock");
+    EXPECT_EQ(un.to_string(), "unix:/tmp/eventcore.sock");
+
+    EXPECT_EQ(Address::unix_path("@eventcore").value().path(), "@eventcore");
+}
+
+TEST(AddressTest, RejectsUnixPathsThatDoNotFit) {
+    const size_t max = sizeof(sockaddr_un::sun_path) - 1;
+    auto longest = Address::unix_path("/" + std::string(max - 1, 'p'));
+    ASSERT_TRUE(longest.is_ok());
+    EXPECT_EQ(longest.value().path(), "/" + std::string(max - 1, 'p'));
+    EXPECT_TRUE(Address::unix_path("/" + std::string(max, 'p')).is_err());
+
+    auto abstract = Address::unix_path("@" + std::string(max - 1, 'a'));
+    ASSERT_TRUE(abstract.is_ok());
+    EXPECT_EQ(abstract.value().path(), "@" + std::string(max - 1, 'a'));
+    EXPECT_TRUE(Address::unix_path("@" + std::string(max, 'a')).is_err());
+
+    EXPECT_TRUE(Address::parse("unix:/" + std::string(max, 'p')).is_err());
+}
+
+TEST(AddressTest, Parse) {
+    auto v4 = Address::parse("127.0.0.1:80");
+    ASSERT_TRUE(v4.is_ok());
+    EXPECT_TRUE(v4.value().is_ipv4());
+    EXPECT_EQ(v4.value().port(), 80);
+
+    auto v6 = Address::parse("[::]:8080");
+    ASSERT_TRUE(v6.is_ok());
+    EXPECT_TRUE(v6.value().is_ipv6());
+    EXPECT_EQ(v6.value().ip(), "::");
+
+    auto un = Address::parse("unix:/tmp/x.sock");
+    ASSERT_TRUE(un.is_ok());
+    EXPECT_EQ(un.value().path(), "/tmp/x.sock");
+
+    EXPECT_TRUE(Address::parse("localhost").is_err());
+    EXPECT_TRUE(Address::parse("1.2.3.4:99999").is_err());
+    EXPECT_TRUE(Address::parse("::1:80").is_err());
+    EXPECT_TRUE(Address::parse("unix:").is_err());
+}
+
+#ifdef __linux__
+TEST(PollerTest, ReportsSaturatedPollsAndReadyTime) {
+    eventcore::net::EpollPoller poller;
+    const size_t initial = poller.stats().event_capacity;
+    ASSERT_GT(initial, 0u);
+
+    std::vector<int> fds;
+    int handled = 0;
+    for (size_t i = 0; i < initial + 4; ++i) {
+        int pipe_fds[2];
+        ASSERT_EQ(pipe(pipe_fds), 0);
+        ASSERT_EQ(write(pipe_fds[1], "x", 1), 1);
+        fds.push_back(pipe_fds[0]);
+        fds.push_back(pipe_fds[1]);
+        ASSERT_TRUE(poller.add(pipe_fds[0], eventcore::net::Poller::kReadable,
+                    [&handled](int, int) { ++handled; }));
+    }
+
+    const auto before = std::chrono::steady_clock::now();
+    EXPECT_EQ(poller.poll(100), static_cast<int>(initial));
+    EXPECT_GE(poller.ready_time(), before);
+    EXPECT_EQ(poller.stats().saturated_polls, 1u);
+    EXPECT_EQ(poller.stats().event_capacity, initial * 2);
+
+    EXPECT_EQ(poller.poll(100), 4);
+    EXPECT_EQ(poller.stats().saturated_polls, 1u);
+    EXPECT_EQ(handled, static_cast<int>(initial + 4));
+
+    for (int fd : fds) close(fd);
+}
+#endif
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -1,5 +1,13 @@
 #include <gtest/gtest.h>
 #include "eventcore/server/config.h"
+#include "eventcore/server/server.h"
+#include "eventcore/server/connection_pool.h"
+#include "eventcore/net/socket.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
 
 using namespace eventcore::server;
 
@@ -8,6 +16,495 @@ TEST(ConfigTest, DefaultValues) {
     EXPECT_EQ(cfg.port, 8080);
     EXPECT_EQ(cfg.host, "0.0.0.0");
     EXPECT_TRUE(cfg.tcp_nodelay);
+    EXPECT_EQ(cfg.tcp_defer_accept_sec, 0);
+    EXPECT_FALSE(cfg.tcp_fastopen);
+    EXPECT_TRUE(cfg.enable_metrics);
+    EXPECT_TRUE(cfg.metrics_path.empty());
+    EXPECT_TRUE(cfg.trace_path.empty());
+}
+
+TEST(ConnectionPoolTest, ShardsAreIndependent) {
+    ConnectionPool pool(5, 2);
+    EXPECT_EQ(pool.num_shards(), 2u);
+    EXPECT_EQ(pool.available(0), 3u);
+    EXPECT_EQ(pool.available(1), 2u);
+
+    auto handler = [](const eventcore::http::Request&) { return eventcore::http::Response(); };
+    int fds[3];
+    for (int& fd : fds) fd = dup(STDERR_FILENO);
+
+    auto& shard = pool.shard(1);
+    uint32_t slots[3];
+    EXPECT_NE(shard.acquire(fds[0], handler, &slots[0]), nullptr);
+    EXPECT_NE(shard.acquire(fds[1], handler, &slots[1]), nullptr);
+    // Shard 1 is exhausted even though shard 0 still has slots
+    EXPECT_EQ(shard.acquire(fds[2], handler, &slots[2]), nullptr);
+    EXPECT_EQ(pool.available(0), 3u);
+    EXPECT_EQ(pool.available(), 3u);
+
+    EXPECT_EQ(shard.slot_of(fds[1]), slots[1]);
+    EXPECT_EQ(shard.fd_of(slots[1]), fds[1]);
+
+    shard.release(slots[0]);
+    EXPECT_EQ(shard.slot_of(fds[0]), ConnectionPool::Shard::kNoSlot);
+    EXPECT_EQ(pool.available(1), 1u);
+    EXPECT_EQ(shard.active(), 1u);
+    ::close(fds[2]);
+}
+
+TEST(ConnectionPoolTest, ReleaseKeepsMappingOfReusedFd) {
+    ConnectionPool pool(2);
+    auto& shard = pool.shard(0);
+    auto handler = [](const eventcore::http::Request&) { return eventcore::http::Response(); };
+
+    int fd = dup(STDERR_FILENO);
+    uint32_t first = 0;
+    uint32_t second = 0;
+    auto conn = shard.acquire(fd, handler, &first);
+    ASSERT_NE(conn, nullptr);
+    conn->close_socket();
+
+    // The same fd number bound again before the first slot was released
+    int reused = dup(STDERR_FILENO);
+    ASSERT_EQ(reused, fd);
+    ASSERT_NE(shard.acquire(reused, handler, &second), nullptr);
+    shard.release(first);
+    EXPECT_EQ(shard.slot_of(reused), second);
+}
+
+TEST(ConnectionPoolTest, CommitsConnectionMemoryLazily) {
+    ConnectionPool pool(100000, 1, eventcore::HugePageMode::kTransparent);
+    EXPECT_EQ(pool.committed_bytes(), 0u);
+
+    auto& shard = pool.shard(0);
+    auto handler = [](const eventcore::http::Request&) { return eventcore::http::Response(); };
+    uint32_t slots[2];
+    auto first = shard.acquire(dup(STDERR_FILENO), handler, &slots[0]);
+    auto second = shard.acquire(dup(STDERR_FILENO), handler, &slots[1]);
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(pool.committed_bytes(), eventcore::ChunkedArena::kChunkSize);
+
+    // Neighbouring slots are neighbouring objects
+    auto gap = reinterpret_cast<const char*>(second.get()) - reinterpret_cast<const char*>(first.get());
+    EXPECT_GE(gap, static_cast<std::ptrdiff_t>(sizeof(eventcore::http::Connection)));
+    EXPECT_EQ(gap % static_cast<std::ptrdiff_t>(eventcore::ChunkedArena::kSlotAlign), 0);
+    EXPECT_LT(gap, static_cast<std::ptrdiff_t>(sizeof(eventcore::http::Connection) + eventcore::ChunkedArena::kSlotAlign));
+}
+
+TEST(ConnectionPoolTest, ExplicitHugePagesFallBackToRegularPages) {
+    // Holds whether or not huge pages are reserved; with none (the usual
+    // vm.nr_hugepages=0) every chunk takes the regular-page fallback.
+    ConnectionPool pool(100, 1, eventcore::HugePageMode::kExplicit);
+    auto& shard = pool.shard(0);
+    auto handler = [](const eventcore::http::Request&) { return eventcore::http::Response(); };
+    uint32_t slot = 0;
+    auto conn = shard.acquire(dup(STDERR_FILENO), handler, &slot);
+    ASSERT_NE(conn, nullptr);
+    EXPECT_EQ(pool.committed_bytes(), eventcore::ChunkedArena::kChunkSize);
+    conn->close_socket();
+    shard.release(slot);
+    conn.reset();
+}
+
+// Sends one request on an already connected socket and reads until the
+// response body ("ok") has arrived.
+static std::string round_trip(eventcore::net::Socket& sock, const std::string& request) {
+    auto send_result = sock.send(request.data(), request.size());
+    if (send_result.is_err()) return "";
+
+    std::string response;
+    char buf[1024];
+    while (response.find("\r\n\r\nok") == std::string::npos) {
+        auto recv_result = sock.recv(buf, sizeof(buf));
+        if (recv_result.is_err() || recv_result.value() == 0) break;
+        response.append(buf, recv_result.value());
+    }
+    return response;
+}
+
+TEST(ServerTest, KeepAliveRequestsOverAcceptedConnection) {
+    Config cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = 0;
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+
+    Server server(cfg);
+    server.router().get("/ping", [](const eventcore::http::Request&) {
+            eventcore::http::Response resp;
+            resp.set_body("ok");
+            return resp;
+            });
+    server.start();
+
+    auto client_result = eventcore::net::Socket::create_tcp();
+    ASSERT_TRUE(client_result.is_ok());
+    eventcore::net::Socket client = std::move(client_result.value());
+    ASSERT_TRUE(client.connect(server.local_address()).is_ok());
+
+    struct timeval tv = {5, 0};
+    setsockopt(client.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    const std::string request = "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    for (int i = 0; i < 3; ++i) {
+        std::string response = round_trip(client, request);
+        EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << "request " << i;
+    }
+    EXPECT_EQ(server.active_connections(), 1u);
+
+    // The peer's close is handled on a pool thread and released by the worker
+    client.close();
+    for (int i = 0; i < 100 && server.active_connections() != 0; ++i) {
+        usleep(10000);
+    }
+    EXPECT_EQ(server.active_connections(), 0u);
+    server.stop();
+}
+
+TEST(ServerTest, ReportsEphemeralPortsOnceReady) {
+    Config cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = 0;
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+
+    Server first(cfg);
+    Server second(cfg);
+    EXPECT_EQ(first.local_address().port(), 0);
+    EXPECT_FALSE(first.wait_until_ready(std::chrono::milliseconds(0)));
+
+    // Started elsewhere, as an application's main thread would
+    std::thread starter([&first, &second]() {
+            first.start();
+            second.start();
+            });
+    ASSERT_TRUE(first.wait_until_ready(std::chrono::seconds(5)));
+    ASSERT_TRUE(second.wait_until_ready(std::chrono::seconds(5)));
+    starter.join();
+
+    const eventcore::net::Address a = first.local_address();
+    const eventcore::net::Address b = second.local_address();
+    EXPECT_EQ(a.ip(), "127.0.0.1");
+    EXPECT_NE(a.port(), 0);
+    EXPECT_NE(b.port(), 0);
+    EXPECT_NE(a.port(), b.port());
+    EXPECT_EQ(first.local_addresses().size(), 1u);
+
+    auto client_result = eventcore::net::Socket::create_tcp();
+    ASSERT_TRUE(client_result.is_ok());
+    EXPECT_TRUE(client_result.value().connect(b).is_ok());
+
+    first.stop();
+    EXPECT_EQ(first.local_address().port(), 0);
+    second.stop();
+}
+
+TEST(ServerTest, ListensOnUnixAndIPv6AddressesAtOnce) {
+    const std::string path = "/tmp/eventcore_test_server.sock";
+    Config cfg;
+    cfg.listen_addresses = {"unix:" + path, "[::]:0"};
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+
+    Server server(cfg);
+    server.router().get("/ping", [](const eventcore::http::Request&) {
+            eventcore::http::Response resp;
+            resp.set_body("ok");
+            return resp;
+            });
+    server.start();
+
+    const std::string request = "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    const uint16_t port = server.local_address(1).port();
+    ASSERT_NE(port, 0);
+    const eventcore::net::Address targets[] = {
+        eventcore::net::Address::unix_path(path).value(),
+        eventcore::net::Address("::1", port),
+        eventcore::net::Address("127.0.0.1", port),  // IPv4-mapped via the dual-stack listener
+    };
+    for (const auto& target : targets) {
+        auto client_result = eventcore::net::Socket::create_tcp(target.family());
+        ASSERT_TRUE(client_result.is_ok());
+        eventcore::net::Socket client = std::move(client_result.value());
+        ASSERT_TRUE(client.connect(target).is_ok()) << target.to_string();
+
+        struct timeval tv = {5, 0};
+        setsockopt(client.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        std::string response = round_trip(client, request);
+        EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << target.to_string();
+    }
+
+    server.stop();
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
+
+TEST(ServerTest, UnixListenerOnlyReplacesStaleSockets) {
+    const std::string path = "/tmp/eventcore_test_stale.sock";
+    ::unlink(path.c_str());
+    Config cfg;
+    cfg.listen_addresses = {"unix:" + path};
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+
+    // A file that is not a socket is never deleted
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        ASSERT_NE(file, nullptr);
+        fclose(file);
+        Server server(cfg);
+        EXPECT_THROW(server.start(), std::runtime_error);
+        EXPECT_EQ(access(path.c_str(), F_OK), 0);
+        ::unlink(path.c_str());
+    }
+
+    // A socket left behind by a process that is gone is replaced
+    const eventcore::net::Address addr = eventcore::net::Address::unix_path(path).value();
+    {
+        auto stale = eventcore::net::Socket::create_tcp(AF_UNIX);
+        ASSERT_TRUE(stale.is_ok());
+        ASSERT_TRUE(stale.value().bind(addr).is_ok());
+    }
+    Server first(cfg);
+    first.start();
+
+    // A socket that is still being listened on is not taken over
+    {
+        Server second(cfg);
+        EXPECT_THROW(second.start(), std::runtime_error);
+    }
+    auto client = eventcore::net::Socket::create_tcp(AF_UNIX);
+    ASSERT_TRUE(client.is_ok());
+    EXPECT_TRUE(client.value().connect(addr).is_ok());
+
+    // stop() leaves a path that now belongs to someone else
+    ::unlink(path.c_str());
+    FILE* replacement = fopen(path.c_str(), "w");
+    ASSERT_NE(replacement, nullptr);
+    fclose(replacement);
+    first.stop();
+    EXPECT_EQ(access(path.c_str(), F_OK), 0);
+    ::unlink(path.c_str());
+}
+
+TEST(ServerTest, BusyPollModeServesRequestsAndReportsSpinTime) {
+    Config cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = 0;
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+    cfg.busy_poll = true;
+    cfg.busy_poll_budget_us = 200;
+    cfg.affinity = AffinityPolicy::kPerPhysicalCore;
+
+    Server server(cfg);
+    server.router().get("/ping", [](const eventcore::http::Request&) {
+            eventcore::http::Response resp;
+            resp.set_body("ok");
+            return resp;
+            });
+    server.start();
+
+    auto client_result = eventcore::net::Socket::create_tcp();
+    ASSERT_TRUE(client_result.is_ok());
+    eventcore::net::Socket client = std::move(client_result.value());
+    ASSERT_TRUE(client.connect(server.local_address()).is_ok());
+
+    struct timeval tv = {5, 0};
+    setsockopt(client.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    std::string response = round_trip(client, "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+
+    client.close();
+    server.stop();
+
+    auto stats = server.worker_loop_stats();
+    ASSERT_EQ(stats.size(), 1u);
+    EXPECT_GT(stats[0].spin_ns, 0u);
+    EXPECT_GT(stats[0].spin_hits + stats[0].spin_misses, 0u);
+}
+
+// Sends one request with Connection: close on a new connection and reads the
+// response until the server closes.
+static std::string fetch(const Server& server, const std::string& path) {
+    auto client_result = eventcore::net::Socket::create_tcp();
+    if (client_result.is_err()) return "";
+    eventcore::net::Socket client = std::move(client_result.value());
+    if (client.connect(server.local_address()).is_err()) return "";
+    struct timeval tv = {5, 0};
+    setsockopt(client.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    const std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    if (client.send(request.data(), request.size()).is_err()) return "";
+    std::string response;
+    char buf[4096];
+    while (true) {
+        auto recv_result = client.recv(buf, sizeof(buf));
+        if (recv_result.is_err() || recv_result.value() == 0) break;
+        response.append(buf, recv_result.value());
+    }
+    return response;
+}
+
+TEST(ServerTest, MetricsRouteIsOptInAndYieldsToApplicationRoutes) {
+    Config cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = 0;
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+
+    {
+        // Metrics are collected by default but not served
+        Server server(cfg);
+        server.start();
+        const std::string response = fetch(server, "/metrics");
+        EXPECT_EQ(response.compare(0, 22, "HTTP/1.1 404 Not Found"), 0) << response;
+        EXPECT_NE(server.metrics().render().find("eventcore_connections_accepted_total 1\n"), std::string::npos);
+        server.stop();
+    }
+
+    {
+        // The application's own /metrics handler keeps the path
+        cfg.metrics_path = "/metrics";
+        Server server(cfg);
+        server.router().get("/metrics", [](const eventcore::http::Request&) {
+                eventcore::http::Response resp;
+                resp.set_body("application metrics");
+                return resp;
+                });
+        server.start();
+        const std::string response = fetch(server, "/metrics");
+        EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << response;
+        EXPECT_NE(response.find("\r\n\r\napplication metrics"), std::string::npos);
+        EXPECT_EQ(response.find("eventcore_connections_accepted_total"), std::string::npos);
+        server.stop();
+    }
+}
+
+TEST(ServerTest, ServesPrometheusMetrics) {
+    Config cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = 0;
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+    cfg.metrics_path = "/metrics";
+
+    Server server(cfg);
+    server.router().get("/ping", [](const eventcore::http::Request&) {
+            eventcore::http::Response resp;
+            resp.set_body("ok");
+            return resp;
+            });
+    server.start();
+
+    auto client_result = eventcore::net::Socket::create_tcp();
+    ASSERT_TRUE(client_result.is_ok());
+    eventcore::net::Socket client = std::move(client_result.value());
+    ASSERT_TRUE(client.connect(server.local_address()).is_ok());
+    struct timeval tv = {5, 0};
+    setsockopt(client.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    for (int i = 0; i < 2; ++i) {
+        round_trip(client, "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    }
+
+    const std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    ASSERT_TRUE(client.send(request.data(), request.size()).is_ok());
+    std::string response;
+    char buf[4096];
+    while (true) {
+        auto recv_result = client.recv(buf, sizeof(buf));
+        if (recv_result.is_err() || recv_result.value() == 0) break;
+        response.append(buf, recv_result.value());
+    }
+    server.stop();
+
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+    EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(response.find("eventcore_connections_accepted_total 1\n"), std::string::npos);
+    EXPECT_NE(response.find("eventcore_http_requests_total{worker=\"0\"} 2\n"), std::string::npos);
+    EXPECT_NE(response.find("eventcore_connections_active{worker=\"0\"} 1\n"), std::string::npos);
+    EXPECT_NE(response.find("eventcore_connection_pool_available{shard=\"0\"} 15\n"), std::string::npos);
+    EXPECT_NE(response.find("# TYPE eventcore_bytes_sent_total counter"), std::string::npos);
+    EXPECT_NE(response.find("eventcore_stage_seconds_count{stage=\"handler\",route=\"/ping\"} 2\n"),
+            std::string::npos);
+    EXPECT_NE(response.find("eventcore_stage_seconds_count{stage=\"handler\",route=\"*\"} 2\n"),
+            std::string::npos);
+    EXPECT_NE(response.find("eventcore_stage_seconds{stage=\"parse\",route=\"*\",quantile=\"0.99\"}"),
+            std::string::npos);
+    EXPECT_NE(response.find("eventcore_stage_seconds_count{stage=\"queue_wait\",route=\"*\"}"),
+            std::string::npos);
+    EXPECT_NE(response.find("eventcore_loop_readiness_lag_seconds{worker=\"0\",quantile=\"0.99\"}"),
+            std::string::npos);
+    EXPECT_NE(response.find("eventcore_loop_events_per_poll_bucket{worker=\"0\",le=\"+Inf\"}"),
+            std::string::npos);
+    EXPECT_NE(response.find("eventcore_poller_saturated_total{worker=\"0\"} 0\n"), std::string::npos);
+}
+
+TEST(ServerTest, FlightRecorderTracesRequests) {
+    Config cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = 0;
+    cfg.num_workers = 1;
+    cfg.num_threads_per_worker = 1;
+    cfg.connection_pool_size = 16;
+    cfg.trace_path = "/debug/trace";
+
+    Server server(cfg);
+    server.router().get("/ping", [](const eventcore::http::Request&) {
+            eventcore::http::Response resp;
+            resp.set_body("ok");
+            return resp;
+            });
+    server.start();
+
+    auto client_result = eventcore::net::Socket::create_tcp();
+    ASSERT_TRUE(client_result.is_ok());
+    eventcore::net::Socket client = std::move(client_result.value());
+    ASSERT_TRUE(client.connect(server.local_address()).is_ok());
+    struct timeval tv = {5, 0};
+    setsockopt(client.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    round_trip(client, "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    const std::string request = "GET /debug/trace?format=json HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    ASSERT_TRUE(client.send(request.data(), request.size()).is_ok());
+    std::string response;
+    char buf[4096];
+    while (true) {
+        auto recv_result = client.recv(buf, sizeof(buf));
+        if (recv_result.is_err() || recv_result.value() == 0) break;
+        response.append(buf, recv_result.value());
+    }
+    server.stop();
+
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+    EXPECT_NE(response.find("Content-Type: application/json"), std::string::npos);
+    EXPECT_NE(response.find("{\"name\":\"accept\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":1,"),
+            std::string::npos);
+    EXPECT_NE(response.find("{\"name\":\"handler\",\"ph\":\"B\",\"pid\":0,\"tid\":1,"), std::string::npos);
+    EXPECT_NE(response.find("\"args\":{\"status\":200}"), std::string::npos);
+    EXPECT_NE(response.find("\"name\":\"write_complete\""), std::string::npos);
+
+    // The trace request itself completed after the route took its snapshot
+    std::vector<eventcore::trace::Event> events = server.trace_events();
+    ASSERT_FALSE(events.empty());
+    EXPECT_EQ(events.front().type, eventcore::trace::EventType::kAccept);
+    size_t handled = 0;
+    for (const auto& event : events) {
+        if (event.type == eventcore::trace::EventType::kHandlerEnd) ++handled;
+    }
+    EXPECT_EQ(handled, 2u);
+    EXPECT_EQ(events.back().type, eventcore::trace::EventType::kClose);
 }
 
 int main(int argc, char **argv) {
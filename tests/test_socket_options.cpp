@@ -48,6 +48,7 @@ TCP_QUICKACK    int Enable/disable delayed ACK temporarily.
 #include "eventcore/net/address.h"
 #include <sys/socket.h>
 #include <netinet/tcp.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <thread>
 #include <chrono>
@@ -269,6 +270,80 @@ TEST_F(SocketOptionsTest, NoDelayToggle) {
     EXPECT_EQ(value3, 1);
 }
 
+// ============================================================================
+// TCP_DEFER_ACCEPT / TCP_FASTOPEN Tests (listening socket)
+// ============================================================================
+
+#ifdef TCP_DEFER_ACCEPT
+TEST_F(SocketOptionsTest, SetDeferAcceptEnable) {
+    auto result = socket_.set_defer_accept(5);
+    EXPECT_TRUE(result.is_ok());
+
+    // The kernel stores the timeout as a SYN-ACK retransmit count, so the value
+    // read back is rounded up to the next retransmit boundary
+    int value = get_socket_option<int>(socket_.fd(), IPPROTO_TCP, TCP_DEFER_ACCEPT);
+    EXPECT_GE(value, 5);
+}
+
+TEST_F(SocketOptionsTest, SetDeferAcceptDisable) {
+    ASSERT_TRUE(socket_.set_defer_accept(5).is_ok());
+    auto result = socket_.set_defer_accept(0);
+    EXPECT_TRUE(result.is_ok());
+
+    int value = get_socket_option<int>(socket_.fd(), IPPROTO_TCP, TCP_DEFER_ACCEPT);
+    EXPECT_EQ(value, 0);
+}
+#endif
+
+#ifdef TCP_FASTOPEN
+TEST_F(SocketOptionsTest, SetFastOpenQueueLength) {
+    auto result = socket_.set_fastopen(128);
+    EXPECT_TRUE(result.is_ok());
+
+    int value = get_socket_option<int>(socket_.fd(), IPPROTO_TCP, TCP_FASTOPEN);
+    EXPECT_EQ(value, 128);
+}
+
+TEST_F(SocketOptionsTest, FastOpenPersistsAfterListen) {
+    uint16_t test_port = 20007;
+    Address addr("127.0.0.1", test_port);
+
+    EXPECT_TRUE(socket_.set_reuseaddr(true).is_ok());
+    EXPECT_TRUE(socket_.set_fastopen(256).is_ok());
+    EXPECT_TRUE(socket_.set_defer_accept(1).is_ok());
+    ASSERT_TRUE(socket_.bind(addr).is_ok());
+    ASSERT_TRUE(socket_.listen().is_ok());
+
+    EXPECT_EQ(get_socket_option<int>(socket_.fd(), IPPROTO_TCP, TCP_FASTOPEN), 256);
+    EXPECT_GE(get_socket_option<int>(socket_.fd(), IPPROTO_TCP, TCP_DEFER_ACCEPT), 1);
+}
+#endif
+
+#ifdef SO_BUSY_POLL
+TEST_F(SocketOptionsTest, SetBusyPoll) {
+    auto result = socket_.set_busy_poll(50);
+    if (result.is_err()) {
+        // Raising SO_BUSY_POLL above net.core.busy_read needs CAP_NET_ADMIN
+        GTEST_SKIP() << result.error();
+    }
+
+    int value = get_socket_option<int>(socket_.fd(), SOL_SOCKET, SO_BUSY_POLL);
+    EXPECT_EQ(value, 50);
+}
+#endif
+
+#ifdef SO_PREFER_BUSY_POLL
+TEST_F(SocketOptionsTest, SetPreferBusyPoll) {
+    auto result = socket_.set_prefer_busy_poll(true);
+    if (result.is_err()) {
+        GTEST_SKIP() << result.error();
+    }
+
+    int value = get_socket_option<int>(socket_.fd(), SOL_SOCKET, SO_PREFER_BUSY_POLL);
+    EXPECT_EQ(value, 1);
+}
+#endif
+
 // ============================================================================
 // SO_KEEPALIVE Tests
 // ============================================================================
@@ -524,6 +599,41 @@ TEST_F(SocketOptionsTest, E2E_RapidRebindScenario) {
     }
 }
 
+// Accepted sockets come back non-blocking and close-on-exec without extra fcntl calls
+TEST_F(SocketOptionsTest, E2E_AcceptAppliesFlagsAndReportsPeer) {
+    uint16_t test_port = 20006;
+    Address server_addr("127.0.0.1", test_port);
+
+    auto server_result = Socket::create_tcp();
+    ASSERT_TRUE(server_result.is_ok());
+    Socket server_socket = std::move(server_result.value());
+
+    server_socket.set_reuseaddr(true);
+    ASSERT_TRUE(server_socket.bind(server_addr).is_ok());
+    ASSERT_TRUE(server_socket.listen(1).is_ok());
+
+    auto client_result = Socket::create_tcp();
+    ASSERT_TRUE(client_result.is_ok());
+    Socket client_socket = std::move(client_result.value());
+    ASSERT_TRUE(client_socket.connect(server_addr).is_ok());
+
+    Address peer;
+    auto accept_result = server_socket.accept(&peer);
+    ASSERT_TRUE(accept_result.is_ok());
+    Socket client_conn = std::move(accept_result.value());
+
+    EXPECT_TRUE(fcntl(client_conn.fd(), F_GETFL) & O_NONBLOCK);
+    EXPECT_TRUE(fcntl(client_conn.fd(), F_GETFD) & FD_CLOEXEC);
+    EXPECT_EQ(peer.ip(), "127.0.0.1");
+    EXPECT_NE(peer.port(), 0);
+
+    // Nothing pending: a non-blocking accept reports EAGAIN instead of blocking
+    ASSERT_TRUE(server_socket.set_nonblocking(true).is_ok());
+    auto again_result = server_socket.accept(&peer);
+    EXPECT_TRUE(again_result.is_err());
+    EXPECT_TRUE(errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
 // ============================================================================
 // TCP Keepalive Advanced Tests
 // ============================================================================
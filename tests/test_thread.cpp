@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 #include "eventcore/thread/blocking_queue.h"
 #include "eventcore/thread/thread_pool.h"
+#include "eventcore/thread/affinity.h"
+#include "eventcore/core/alloc_counter.h"
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sched.h>
 
 using namespace eventcore::thread;
 
@@ -144,6 +151,68 @@ TEST(ThreadPoolTest, StopWithPendingTasks) {
     EXPECT_GE(counter.load(), 1);
 }
 
+TEST(AffinityTest, TopologyCoversAllowedCpus) {
+    CpuTopology topology = CpuTopology::detect();
+
+    ASSERT_FALSE(topology.cpus().empty());
+    EXPECT_EQ(topology.logical_cpus().size(), available_cpu_count());
+    EXPECT_GE(topology.num_nodes(), 1u);
+
+    // One entry per physical core, none of them hyperthread siblings of another
+    auto cores = topology.physical_cores();
+    ASSERT_FALSE(cores.empty());
+    EXPECT_LE(cores.size(), topology.cpus().size());
+    for (int cpu : cores) {
+        for (int sibling : topology.siblings_of(cpu)) {
+            EXPECT_EQ(std::count(cores.begin(), cores.end(), sibling), 0);
+        }
+    }
+}
+
+TEST(AffinityTest, PinnedPoolThreadsStayOnTheirCpu) {
+    int cpu = CpuTopology::detect().logical_cpus().front();
+
+    ThreadPool pool(2);
+    pool.set_cpu_affinity({cpu});
+    pool.start();
+
+    std::atomic<int> on_cpu{0};
+    for (int i = 0; i < 4; ++i) {
+        pool.submit([&on_cpu, cpu]() {
+                if (sched_getcpu() == cpu) on_cpu.fetch_add(1);
+                });
+    }
+    pool.stop();  // Drains the queue
+
+    EXPECT_EQ(on_cpu.load(), 4);
+}
+
+TEST(AllocCounterTest, CountsCallingThreadAndWholeProcess) {
+    if (!eventcore::alloc::counting_enabled()) {
+        GTEST_SKIP() << "Configure with -DEVENTCORE_ALLOC_COUNTING=ON to count allocations";
+    }
+    eventcore::alloc::Scope thread_scope;
+    eventcore::alloc::Scope process_scope(true);
+
+    std::vector<std::unique_ptr<std::string>> kept;
+    std::thread other([&kept] {
+        for (int i = 0; i < 10; ++i) kept.emplace_back(new std::string(100, 'x'));
+        kept.clear();
+    });
+    other.join();
+    std::unique_ptr<int> own(new int(7));
+    EXPECT_EQ(*own, 7);
+
+    const auto mine = thread_scope.delta();
+    EXPECT_GE(mine.allocations, 1u);
+    EXPECT_LT(mine.allocations, 10u);
+    EXPECT_GE(mine.bytes, sizeof(int));
+    const auto all = process_scope.delta();
+    EXPECT_GE(all.allocations, 11u);
+    EXPECT_GE(all.deallocations, 10u);
+    EXPECT_GE(all.bytes, 10 * (100 + sizeof(std::string)) + sizeof(int));
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();